@@ -0,0 +1,642 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <array>
+#include <chrono>
+#include <complex>
+#include <limits>
+#include <algorithm>
+#include <thread>
+
+#include <shared_processing_code/shared_processing_code.h>
+#include "../../Plugin/Source/IFFT.hpp"
+#include "../../Plugin/Source/TimeDomain.hpp"
+#include "../../Plugin/Source/EngineSelector.hpp"
+
+const double sampleRate = 48000.0;
+const int bufferSize = 256;
+const int partialCount = 10000;
+const int iterations = 100;
+const int runs = 5;
+
+// Mean duration of one call in milliseconds, fastest of several runs
+template <typename Function>
+double measure(Function&& function)
+{
+    // Warm up caches and the phase state
+    function();
+
+    double fastest = 0.0;
+
+    for (int run = 0; run < runs; ++run)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        for (int i = 0; i < iterations; ++i)
+            function();
+
+        auto end = std::chrono::high_resolution_clock::now();
+
+        double mean = std::chrono::duration<double, std::milli>(end - start).count() / static_cast<double>(iterations);
+        fastest = (run == 0 || mean < fastest) ? mean : fastest;
+    }
+
+    return fastest;
+}
+
+std::vector<Partial<float>> createNoise(int partials)
+{
+    BasicSignals signal = BasicSignals(SignalType::noise, 0.5, 440.0, 440.0, 0.0);
+    signal.reset();
+    signal.setNumberOfPartials(partials);
+    signal.createSignal(SignalType::noise);
+    signal.setSpatialParameters(1.0, 0.5, 0.2);
+    signal.setAzimuthDisplacement(DisplacementFunction::sin, 0.8, 3.0);
+    signal.setElevationDisplacement(DisplacementFunction::cos, 0.4, 2.0);
+
+    return signal.getPartials();
+}
+
+template <typename T>
+void benchmarkSplat(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    double times[2];
+
+    for (int vectorized = 0; vectorized <= 1; ++vectorized)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        ifft.setVectorizedSplat(vectorized);
+
+        times[vectorized] = measure([&] { ifft.createSpectrum(partials); });
+    }
+
+    std::cout << "createSpectrum (" << precision << "): "
+              << times[0] << " ms (loop), "
+              << times[1] << " ms (" << SpectralSplat<T>::getInstructionSet() << " kernel), "
+              << "speedup " << times[0] / times[1] << "\n";
+
+    benchmarkFile << precision << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+}
+
+template <typename T>
+void benchmarkLayout(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    double times[2];
+    int blockChannels = AC;
+
+    for (int interleaved = 0; interleaved <= 1; ++interleaved)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        ifft.setSpectrumLayout(interleaved ? SpectrumLayout::Interleaved : SpectrumLayout::ChannelMajor);
+        blockChannels = ifft.getBlockChannels();
+
+        // The deinterleave step is part of IFFTprocess, so both stages are measured
+        times[interleaved] = measure([&] { ifft.createSpectrum(partials); ifft.IFFTprocess(); });
+    }
+
+    std::cout << "createSpectrum + IFFTprocess (" << precision << "): "
+              << times[0] << " ms (channel-major), "
+              << times[1] << " ms (interleaved, " << blockChannels << " channels per block), "
+              << "speedup " << times[0] / times[1] << "\n";
+
+    benchmarkFile << precision << "," << blockChannels << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+}
+
+template <typename T>
+void benchmarkStaging(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+    ifft.setSampleRate(sampleRate);
+    ifft.setChannels(AC);
+
+    double after = measure([&] { ifft.createSpectrum(partials); ifft.IFFTprocess(); });
+
+    // The per hop copy of the removed std::complex staging arrays into the KFR input. The staged
+    // path itself is gone, so its time is estimated as the direct time plus this copy
+    const int bins = 2 * bufferSize + 1;
+    std::array<std::vector<std::complex<T>>, AC> staging;
+    std::array<kfr::univector<kfr::complex<T>>, AC> input;
+
+    for (int c = 0; c < AC; ++c)
+    {
+        staging[c].resize(bins, std::complex<T>(1.0, 0.5));
+        input[c].resize(bins, kfr::complex<T>(0.0, 0.0));
+    }
+
+    double copy = measure([&] 
+    { 
+        for (int c = 0; c < AC; ++c)
+        {
+            for (int j = 0; j < bins; ++j)
+                input[c][j] = kfr::complex<T>(staging[c][j].real(), staging[c][j].imag());
+        }
+    });
+
+    std::cout << "createSpectrum + IFFTprocess (" << precision << "): "
+              << after + copy << " ms (staged estimate: direct + copy), "
+              << after << " ms (direct), "
+              << "staging copy " << copy << " ms, "
+              << AC * bins * sizeof(std::complex<T>) / 1024 << " KB staging state removed" << "\n";
+
+    benchmarkFile << precision << "," << after + copy << "," << after << "," << copy << "," << AC * bins * sizeof(std::complex<T>) << "\n";
+}
+
+template <typename T>
+void benchmarkWorkers(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    double serial = 0.0;
+
+    for (int threads = 1; threads <= 8; ++threads)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        ifft.setWorkerThreads(threads);
+        ifft.createSpectrum(partials);
+
+        double time = measure([&] { ifft.IFFTprocess(); });
+        serial = threads == 1 ? time : serial;
+
+        std::cout << "IFFTprocess (" << precision << ", " << threads << " threads): "
+                  << time << " ms, speedup " << serial / time << "\n";
+
+        benchmarkFile << precision << "," << threads << "," << time << "," << serial / time << "\n";
+    }
+}
+
+template <typename T>
+void benchmarkPairing(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    double times[2];
+
+    for (int paired = 0; paired <= 1; ++paired)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        ifft.setChannelPairing(paired);
+        ifft.createSpectrum(partials);
+
+        times[paired] = measure([&] { ifft.IFFTprocess(); });
+    }
+
+    std::cout << "IFFTprocess (" << precision << "): "
+              << times[0] << " ms (" << AC << " real IFFTs), "
+              << times[1] << " ms (" << AC / 2 << " complex IFFTs), "
+              << "speedup " << times[0] / times[1] << "\n";
+
+    benchmarkFile << precision << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+}
+
+template <typename T>
+void benchmarkBatched(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    double times[2];
+
+    for (int batched = 0; batched <= 1; ++batched)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        ifft.setBatchedTransform(batched);
+        ifft.createSpectrum(partials);
+
+        times[batched] = measure([&] { ifft.IFFTprocess(); });
+    }
+
+    std::cout << "IFFTprocess (" << precision << "): "
+              << times[0] << " ms (" << AC << " KFR plans), "
+              << times[1] << " ms (batch of " << AC << "), "
+              << "speedup " << times[0] / times[1] << "\n";
+
+    benchmarkFile << precision << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+}
+
+template <typename T>
+void benchmarkPruned(std::ofstream& benchmarkFile, const std::string& precision)
+{
+    const int frameSize = 4 * bufferSize;
+    const int bins = frameSize / 2 + 1;
+
+    std::vector<std::vector<std::complex<T>>> spectra(AC, std::vector<std::complex<T>>(bins));
+    std::vector<const std::complex<T>*> spectrumPointers(AC);
+    std::vector<std::vector<T>> frames(AC, std::vector<T>(frameSize, 0.0));
+    std::vector<T*> framePointers(AC);
+
+    for (int c = 0; c < AC; ++c)
+    {
+        for (int k = 0; k < bins; ++k)
+            spectra[c][k] = std::complex<T>(std::sin(0.37 * k + c), std::cos(0.61 * k - c));
+
+        spectrumPointers[c] = spectra[c].data();
+        framePointers[c] = frames[c].data();
+    }
+
+    kfr::dft_plan_real<T> plan(frameSize);
+    kfr::univector<kfr::u8> temp(plan.temp_size);
+    BatchedIFFT<T> batch(frameSize, AC);
+
+    for (int overlapFactor = 2; overlapFactor <= 8; overlapFactor *= 2)
+    {
+        const int hopSize = frameSize / overlapFactor;
+
+        const double kfrTime = measure([&] 
+        { 
+            for (int c = 0; c < AC; ++c)
+                plan.execute(framePointers[c], spectrumPointers[c], temp.data());
+        });
+
+        batch.setOutputs(frameSize);
+        const double full = measure([&] { batch.execute(spectrumPointers.data(), 1, AC); });
+
+        batch.getSamples(framePointers.data(), 0, hopSize, AC);
+        batch.getSamples(framePointers.data(), frameSize - hopSize, hopSize, AC);
+        const std::vector<std::vector<T>> reference = frames;
+
+        batch.setOutputs(hopSize);
+        const double pruned = measure([&] { batch.execute(spectrumPointers.data(), 1, AC); });
+
+        batch.getSamples(framePointers.data(), 0, hopSize, AC);
+        batch.getSamples(framePointers.data(), frameSize - hopSize, hopSize, AC);
+
+        // The pruned butterflies compute the read samples exactly like the full transform
+        bool identical = true;
+
+        for (int c = 0; c < AC; ++c)
+        {
+            for (int n = 0; n < frameSize; ++n)
+            {
+                if ((n < hopSize || n >= frameSize - hopSize) && frames[c][n] != reference[c][n])
+                    identical = false;
+            }
+        }
+
+        std::cout << "Overlap factor " << overlapFactor << " (" << precision << "): "
+                  << kfrTime << " ms (" << AC << " KFR plans), "
+                  << full << " ms (batch), " << pruned << " ms (pruned batch), "
+                  << "speedup " << full / pruned << " against the batch, " << kfrTime / pruned << " against KFR"
+                  << (identical ? "" : ", samples differ") << "\n";
+
+        benchmarkFile << precision << "," << overlapFactor << "," << 2 * hopSize << "," << kfrTime << "," << full << "," << pruned << "," 
+                      << full / pruned << "," << kfrTime / pruned << "\n";
+    }
+}
+
+template <typename T>
+void benchmarkCoefficientCache(std::ofstream& benchmarkFile, const std::string& precision)
+{
+    // The plugin draws new noise partials every block, the static case reuses one set every hop
+    const int sets = 8;
+    BasicSignals signal = BasicSignals(SignalType::noise, 0.5, 440.0, 440.0, 0.0);
+    std::vector<std::vector<Partial<float>>> partialSets;
+
+    for (int set = 0; set < sets; ++set)
+    {
+        signal.reset();
+        signal.setNumberOfPartials(partialCount);
+        signal.createSignal(SignalType::noise);
+        signal.setSpatialParameters(1.0, 0.5, 0.2);
+        signal.setAzimuthDisplacement(DisplacementFunction::sin, 0.8, 3.0);
+        signal.setElevationDisplacement(DisplacementFunction::cos, 0.4, 2.0);
+        partialSets.push_back(signal.getPartials());
+    }
+
+    double times[2];
+    float hitRates[2];
+
+    for (int changing = 0; changing <= 1; ++changing)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        int hop = 0;
+
+        times[changing] = measure([&] { ifft.createSpectrum(partialSets[changing ? ++hop % sets : 0]); });
+        hitRates[changing] = ifft.getCoefficientCacheHitRate();
+    }
+
+    std::cout << "createSpectrum (" << precision << "): "
+              << times[0] << " ms (static partials, " << 100.0f * hitRates[0] << "% cache hits), "
+              << times[1] << " ms (new partials every hop, " << 100.0f * hitRates[1] << "% cache hits)" << "\n";
+
+    benchmarkFile << precision << "," << times[0] << "," << hitRates[0] << "," << times[1] << "," << hitRates[1] << "\n";
+}
+
+template <typename T>
+void benchmarkBinSorting(std::ofstream& benchmarkFile, const std::vector<Partial<float>>& partials, const std::string& precision)
+{
+    double times[2];
+
+    for (int sorted = 0; sorted <= 1; ++sorted)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+        ifft.setBinSortedSplat(sorted);
+
+        times[sorted] = measure([&] { ifft.createSpectrum(partials); });
+    }
+
+    std::cout << "createSpectrum (" << precision << "): "
+              << times[0] << " ms (input order), "
+              << times[1] << " ms (bin order), "
+              << "speedup " << times[0] / times[1] << "\n";
+
+    benchmarkFile << precision << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+}
+
+template <typename T>
+void benchmarkCulling(std::ofstream& benchmarkFile, const std::string& precision)
+{
+    // Dull sawtooth: the partials above the first few are damped far below audibility
+    BasicSignals signal = BasicSignals(SignalType::sawtooth, 0.5, 20.0, 20.0, 0.0);
+    signal.createSignal(SignalType::sawtooth);
+    signal.setBrightness(0.5);
+    signal.setSpatialParameters(1.0, 0.5, 0.2);
+    signal.setAzimuthDisplacement(DisplacementFunction::sin, 0.8, 3.0);
+    signal.setElevationDisplacement(DisplacementFunction::cos, 0.4, 2.0);
+    auto partials = signal.getPartials();
+
+    double times[2];
+    int culled = 0;
+
+    for (int culling = 0; culling <= 1; ++culling)
+    {
+        IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+        ifft.setSampleRate(sampleRate);
+        ifft.setChannels(AC);
+
+        if (culling)
+            ifft.setCullingThreshold(-120.0);
+
+        times[culling] = measure([&] { ifft.createSpectrum(partials); ifft.IFFTprocess(); });
+        culled = ifft.getCulledPartials();
+    }
+
+    std::cout << "Sawtooth, brightness 0.5 (" << precision << "): "
+              << culled << " of " << partials.size() << " partials culled, "
+              << times[0] << " ms (all), " << times[1] << " ms (culled), "
+              << "speedup " << times[0] / times[1] << "\n";
+
+    benchmarkFile << precision << "," << partials.size() << "," << culled << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+}
+
+template <typename T>
+void benchmarkParallelSplat(std::ofstream& benchmarkFile, const std::string& precision)
+{
+    const int threads = std::max(2, std::min(8, static_cast<int>(std::thread::hardware_concurrency())));
+    int crossover = 0;
+
+    for (int count: {1000, 2000, 3000, 4000, 6000, 8000, 10000})
+    {
+        auto partials = createNoise(count);
+        double times[2];
+
+        for (int parallel = 0; parallel <= 1; ++parallel)
+        {
+            IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+            ifft.setSampleRate(sampleRate);
+            ifft.setChannels(AC);
+            ifft.setWorkerThreads(threads);
+            ifft.setParallelSplatThreshold(parallel ? 0 : std::numeric_limits<int>::max());
+
+            times[parallel] = measure([&] { ifft.createSpectrum(partials); });
+        }
+
+        crossover = (crossover == 0 && times[1] < times[0]) ? count : crossover;
+
+        std::cout << "createSpectrum (" << precision << ", " << count << " partials): "
+                  << times[0] << " ms (single-threaded), "
+                  << times[1] << " ms (" << threads << " threads), "
+                  << "speedup " << times[0] / times[1] << "\n";
+
+        benchmarkFile << precision << "," << count << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+    }
+
+    // PARALLEL_SPLAT_CROSSOVER in IFFT.hpp should be set from this value
+    std::cout << "Parallel splat crossover (" << precision << "): " << crossover << " partials" << "\n";
+    benchmarkFile << "Crossover" << "," << crossover << "\n";
+}
+
+template <typename T>
+void benchmarkSparse(std::ofstream& benchmarkFile, const std::string& precision)
+{
+    int crossover = 0;
+    int limit = 0;
+
+    for (int count: {1, 2, 3, 4, 6, 8})
+    {
+        auto partials = createNoise(count);
+        double times[2];
+        int bins = 0;
+
+        for (int sparse = 0; sparse <= 1; ++sparse)
+        {
+            IFFT<T> ifft = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 128, 7);
+            ifft.setSampleRate(sampleRate);
+            ifft.setChannels(AC);
+            limit = ifft.getSparseBinLimit();
+            ifft.setSparseBinLimit(sparse ? std::numeric_limits<int>::max() : 0);
+
+            times[sparse] = measure([&] { ifft.createSpectrum(partials); ifft.IFFTprocess(); });
+            bins = sparse ? ifft.getSparseBins() : bins;
+        }
+
+        crossover = times[1] < times[0] ? std::max(crossover, bins + 1) : crossover;
+
+        std::cout << "createSpectrum + IFFTprocess (" << precision << ", " << bins << " occupied bins): "
+                  << times[0] << " ms (transforms), "
+                  << times[1] << " ms (direct synthesis), "
+                  << "speedup " << times[0] / times[1] << "\n";
+
+        benchmarkFile << precision << "," << bins << "," << times[0] << "," << times[1] << "," << times[0] / times[1] << "\n";
+    }
+
+    // SPARSE_SYNTHESIS_COST_FACTOR in IFFT.hpp should bring the cost model close to this value
+    std::cout << "Sparse synthesis crossover (" << precision << "): " << crossover << " bins, cost model " << limit << " bins" << "\n";
+    benchmarkFile << "Crossover" << "," << crossover << "," << "Cost model" << "," << limit << "\n";
+}
+
+void benchmarkEngines(std::ofstream& benchmarkFile)
+{
+    // One host block of each engine, the spectral one renders bufferSize / hop hops per block
+    IFFT<float> ifft = IFFT<float>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 16, 7);
+    ifft.setSampleRate(sampleRate);
+    TimeDomain timeDomain = TimeDomain(bufferSize, static_cast<float>(sampleRate));
+    EngineSelector selector = EngineSelector(4 * bufferSize, ifft.getHopSize(), 7);
+    const int hops = std::max(1, bufferSize / ifft.getHopSize());
+
+    for (int channels: {1, 4, 9, 16})
+    {
+        ifft.setChannels(channels);
+        timeDomain.setChannels(channels);
+        int crossover = 0;
+
+        for (int count: {1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024})
+        {
+            auto partials = createNoise(count);
+
+            double spectral = measure([&] 
+            { 
+                for (int hop = 0; hop < hops; ++hop)
+                {
+                    ifft.createSpectrum(partials); 
+                    ifft.IFFTprocess(); 
+                }
+            });
+
+            double wavetable = measure([&] { timeDomain.process(partials, bufferSize); });
+
+            crossover = (crossover == 0 && spectral < wavetable) ? count : crossover;
+
+            std::cout << "Engines (" << channels << " channels, " << count << " partials): "
+                      << spectral << " ms (IFFT), "
+                      << wavetable << " ms (TimeDomain)" << "\n";
+
+            benchmarkFile << channels << "," << count << "," << spectral << "," << wavetable << "\n";
+        }
+
+        // TIMEDOMAIN_OSCILLATOR_COST in EngineSelector.hpp should bring the cost model close to this value
+        std::cout << "Engine crossover (" << channels << " channels): " << crossover << " partials, cost model " 
+                  << selector.getCrossover(channels, bufferSize) << " partials" << "\n";
+        benchmarkFile << "Crossover" << "," << crossover << "," << "Cost model" << "," << selector.getCrossover(channels, bufferSize) << "\n";
+    }
+}
+
+int main()
+{
+    // Prepare .csv file
+    std::ostringstream filePath;
+    filePath << "./" << "Benchmark" << ".csv";
+    std::ofstream benchmarkFile;
+    benchmarkFile.open(filePath.str());
+
+    benchmarkFile << "Spectral engine benchmark" << "\n" << "\n";
+    benchmarkFile << "Sample rate:" << "," << sampleRate << "\n";
+    benchmarkFile << "Buffer size:" << "," << bufferSize << "\n";
+    benchmarkFile << "Partials:" << "," << partialCount << "\n";
+    benchmarkFile << "Iterations:" << "," << iterations << "\n";
+    benchmarkFile << "Runs:" << "," << runs << "\n" << "\n";
+
+    std::cout << "-----------------------------------------------" << "\n";
+    std::cout << "-------------Spectral Engine Benchmark---------" << "\n";
+    std::cout << "-----------------------------------------------" << "\n";
+
+    auto partials = createNoise(partialCount);
+
+    // Splat: original per bin/channel loop against the vectorized kernel
+    benchmarkFile << "Splat kernel" << "," << SpectralSplat<float>::getInstructionSet() << "\n";
+    benchmarkFile << "Precision" << "," << "Loop [ms]" << "," << "Kernel [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkSplat<float>(benchmarkFile, partials, "float");
+    benchmarkSplat<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // Spectrum layout: separate channel arrays against interleaved L1 sized blocks
+    benchmarkFile << "Spectrum layout" << "\n";
+    benchmarkFile << "Precision" << "," << "Channels per block" << "," << "Channel-major [ms]" << "," << "Interleaved [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkLayout<float>(benchmarkFile, partials, "float");
+    benchmarkLayout<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // Splat into the KFR input against the former std::complex staging arrays
+    benchmarkFile << "IFFT input" << "\n";
+    benchmarkFile << "Precision" << "," << "Staged estimate [ms]" << "," << "Direct [ms]" << "," << "Staging copy [ms]" << "," << "Staging state [bytes]" << "\n";
+
+    benchmarkStaging<float>(benchmarkFile, partials, "float");
+    benchmarkStaging<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // Channel IFFTs and overlap-add on the worker pool
+    benchmarkFile << "Worker threads" << "," << std::thread::hardware_concurrency() << " hardware threads" << "\n";
+    benchmarkFile << "Precision" << "," << "Threads" << "," << "IFFTprocess [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkWorkers<float>(benchmarkFile, partials, "float");
+    benchmarkWorkers<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // Two channels per complex IFFT against one real IFFT per channel
+    benchmarkFile << "Channel pairing" << "\n";
+    benchmarkFile << "Precision" << "," << "Real [ms]" << "," << "Paired [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkPairing<float>(benchmarkFile, partials, "float");
+    benchmarkPairing<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // All channels in one transform vectorized across channels against one KFR plan per channel
+    benchmarkFile << "Batched transform" << "\n";
+    benchmarkFile << "Precision" << "," << "Per channel [ms]" << "," << "Batched [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkBatched<float>(benchmarkFile, partials, "float");
+    benchmarkBatched<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // The batch pruned to the two hops the overlap-add reads against the full batch and the KFR plans
+    benchmarkFile << "Pruned transform" << "\n";
+    benchmarkFile << "Precision" << "," << "Overlap factor" << "," << "Samples read" << "," << "KFR plans [ms]" << "," 
+                  << "Batched [ms]" << "," << "Pruned [ms]" << "," << "Speedup batched" << "," << "Speedup KFR" << "\n";
+
+    benchmarkPruned<float>(benchmarkFile, "float");
+    benchmarkPruned<double>(benchmarkFile, "double");
+    benchmarkFile << "\n";
+
+    // Partials that hold still between hops against new noise partials every hop, as the plugin draws them
+    benchmarkFile << "Coefficient cache" << "\n";
+    benchmarkFile << "Precision" << "," << "Static [ms]" << "," << "Static hit rate" << "," << "Changing [ms]" << "," << "Changing hit rate" << "\n";
+
+    benchmarkCoefficientCache<float>(benchmarkFile, "float");
+    benchmarkCoefficientCache<double>(benchmarkFile, "double");
+    benchmarkFile << "\n";
+
+    // Noise partials splatted in the order of their bins against their random input order
+    benchmarkFile << "Bin sorted splat" << "\n";
+    benchmarkFile << "Precision" << "," << "Input order [ms]" << "," << "Bin order [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkBinSorting<float>(benchmarkFile, partials, "float");
+    benchmarkBinSorting<double>(benchmarkFile, partials, "double");
+    benchmarkFile << "\n";
+
+    // Dropping the partials below -120 dBFS before the splat
+    benchmarkFile << "Partial culling" << "\n";
+    benchmarkFile << "Precision" << "," << "Partials" << "," << "Culled" << "," << "All [ms]" << "," << "Culled [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkCulling<float>(benchmarkFile, "float");
+    benchmarkCulling<double>(benchmarkFile, "double");
+    benchmarkFile << "\n";
+
+    // Partial-partitioned splat with deterministic reduction against the single-threaded splat
+    benchmarkFile << "Parallel splat" << "\n";
+    benchmarkFile << "Precision" << "," << "Partials" << "," << "Single-threaded [ms]" << "," << "Parallel [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkParallelSplat<float>(benchmarkFile, "float");
+    benchmarkParallelSplat<double>(benchmarkFile, "double");
+    benchmarkFile << "\n";
+
+    // Direct synthesis of the occupied bins against the full channel transforms
+    benchmarkFile << "Sparse synthesis" << "\n";
+    benchmarkFile << "Precision" << "," << "Occupied bins" << "," << "Transforms [ms]" << "," << "Direct [ms]" << "," << "Speedup" << "\n";
+
+    benchmarkSparse<float>(benchmarkFile, "float");
+    benchmarkSparse<double>(benchmarkFile, "double");
+    benchmarkFile << "\n";
+
+    // Spectral against wavetable engine per host block, the crossover the hybrid engine switches at
+    benchmarkFile << "Engine crossover" << "\n";
+    benchmarkFile << "Channels" << "," << "Partials" << "," << "IFFT [ms]" << "," << "TimeDomain [ms]" << "\n";
+
+    benchmarkEngines(benchmarkFile);
+    benchmarkFile << "\n";
+
+    std::cout << "-----------------------------------------------" << "\n";
+
+    benchmarkFile.close();
+
+    return 0;
+}
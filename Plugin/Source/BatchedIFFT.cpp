@@ -0,0 +1,178 @@
+#include "BatchedIFFT.hpp"
+
+#include <algorithm>
+
+template <typename T>
+BatchedIFFT<T>::BatchedIFFT(int size, int maxChannels)
+    : m_size(size),
+      m_halfSize(size / 2),
+      m_width(1),
+      m_outputHalf(size / 2)
+{
+    int bits = 0;
+
+    while ((1 << bits) < m_halfSize)
+        ++bits;
+
+    m_bitReversal.resize(m_halfSize, 0);
+
+    for (int k = 0; k < m_halfSize; ++k)
+    {
+        int reversed = 0;
+
+        for (int b = 0; b < bits; ++b)
+            reversed |= ((k >> b) & 1) << (bits - 1 - b);
+
+        m_bitReversal[k] = reversed;
+    }
+
+    m_cos.resize(m_halfSize);
+    m_sin.resize(m_halfSize);
+
+    for (int n = 0; n < m_halfSize; ++n)
+    {
+        m_cos[n] = static_cast<T>(std::cos(2.0 * M_PI * n / m_size));
+        m_sin[n] = static_cast<T>(std::sin(2.0 * M_PI * n / m_size));
+    }
+
+    m_real.resize(m_halfSize * getWidth(maxChannels), 0.0);
+    m_imag.resize(m_halfSize * getWidth(maxChannels), 0.0);
+}
+
+template <typename T>
+void BatchedIFFT<T>::execute(const std::complex<T>* const* spectra, int stride, int channels) noexcept
+{
+    m_width = getWidth(channels);
+
+    switch (m_width)
+    {
+        case 1: transform<1>(spectra, stride, channels); break;
+        case 4: transform<4>(spectra, stride, channels); break;
+        case 8: transform<8>(spectra, stride, channels); break;
+        case 12: transform<12>(spectra, stride, channels); break;
+        default: transform<16>(spectra, stride, channels); break;
+    }
+}
+
+template <typename T>
+template <int Width>
+void BatchedIFFT<T>::transform(const std::complex<T>* const* spectra, int stride, int channels) noexcept
+{
+    // Even and odd samples as one complex sequence: Z[k] = E[k] + i O[k] with
+    // E[k] = X[k] + X[k + N/2] and O[k] = (X[k] - X[k + N/2]) e^(i 2 pi k / N), X[k + N/2] = conj(X[N/2 - k]).
+    // Written in bit reversed order for the stages below, the padding channels are zeroed
+    for (int k = 0; k < m_halfSize; ++k)
+    {
+        T* real = m_real.data() + m_bitReversal[k] * Width;
+        T* imag = m_imag.data() + m_bitReversal[k] * Width;
+        const T cosine = m_cos[k];
+        const T sine = m_sin[k];
+        const bool edge = k == 0;
+
+        for (int c = 0; c < channels; ++c)
+        {
+            const std::complex<T> lower = spectra[c][k * stride];
+            const std::complex<T> upper = spectra[c][(m_halfSize - k) * stride];
+            const T lowerImag = edge ? static_cast<T>(0.0) : lower.imag();
+            const T upperImag = edge ? static_cast<T>(0.0) : -upper.imag();
+
+            const T evenReal = lower.real() + upper.real();
+            const T evenImag = lowerImag + upperImag;
+            const T differenceReal = lower.real() - upper.real();
+            const T differenceImag = lowerImag - upperImag;
+            const T oddReal = differenceReal * cosine - differenceImag * sine;
+            const T oddImag = differenceReal * sine + differenceImag * cosine;
+
+            real[c] = evenReal - oddImag;
+            imag[c] = evenImag + oddReal;
+        }
+
+        for (int c = channels; c < Width; ++c)
+        {
+            real[c] = 0.0;
+            imag[c] = 0.0;
+        }
+    }
+
+    // Radix-2 stages, the twiddle of span s and offset j is e^(i 2 pi j / s) = table[j * N / s].
+    // Output t of a span is read for the outputs t mod s, so a span wider than 2 * m_outputHalf
+    // only needs its top outputs j < m_outputHalf and its bottom outputs j + s / 2 from s - m_outputHalf on
+    for (int span = 2; span <= m_halfSize; span *= 2)
+    {
+        const int half = span / 2;
+        const int twiddleStep = m_size / span;
+        const int topEnd = std::min(half, m_outputHalf);
+        const int bottomStart = std::max(0, half - m_outputHalf);
+
+        for (int block = 0; block < m_halfSize; block += span)
+        {
+            for (int j = 0; j < half; ++j)
+            {
+                if (j == topEnd && j < bottomStart)
+                    j = bottomStart;
+
+                const T cosine = m_cos[j * twiddleStep];
+                const T sine = m_sin[j * twiddleStep];
+                T* __restrict realTop = m_real.data() + (block + j) * Width;
+                T* __restrict imagTop = m_imag.data() + (block + j) * Width;
+                T* __restrict realBottom = m_real.data() + (block + j + half) * Width;
+                T* __restrict imagBottom = m_imag.data() + (block + j + half) * Width;
+
+                if (j < topEnd && j >= bottomStart)
+                {
+                    for (int c = 0; c < Width; ++c)
+                    {
+                        const T real = realBottom[c] * cosine - imagBottom[c] * sine;
+                        const T imag = realBottom[c] * sine + imagBottom[c] * cosine;
+
+                        realBottom[c] = realTop[c] - real;
+                        imagBottom[c] = imagTop[c] - imag;
+                        realTop[c] += real;
+                        imagTop[c] += imag;
+                    }
+                }
+                else if (j < topEnd)
+                {
+                    for (int c = 0; c < Width; ++c)
+                    {
+                        const T real = realBottom[c] * cosine - imagBottom[c] * sine;
+                        const T imag = realBottom[c] * sine + imagBottom[c] * cosine;
+
+                        realTop[c] += real;
+                        imagTop[c] += imag;
+                    }
+                }
+                else
+                {
+                    for (int c = 0; c < Width; ++c)
+                    {
+                        const T real = realBottom[c] * cosine - imagBottom[c] * sine;
+                        const T imag = realBottom[c] * sine + imagBottom[c] * cosine;
+
+                        realBottom[c] = realTop[c] - real;
+                        imagBottom[c] = imagTop[c] - imag;
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void BatchedIFFT<T>::getSamples(T* const* frames, int first, int count, int channels) const noexcept
+{
+    for (int m = first / 2; m < (first + count) / 2; ++m)
+    {
+        const T* real = m_real.data() + m * m_width;
+        const T* imag = m_imag.data() + m * m_width;
+
+        for (int c = 0; c < channels; ++c)
+        {
+            frames[c][2 * m] = real[c];
+            frames[c][2 * m + 1] = imag[c];
+        }
+    }
+}
+
+template class BatchedIFFT<float>;
+template class BatchedIFFT<double>;
@@ -0,0 +1,94 @@
+/**
+ * \class BatchedIFFT
+ *
+ *
+ * \brief Inverse real FFT of all ambisonic channels in one batch.
+ *
+ * The real inverse of size N is computed through one complex inverse of
+ * size N / 2 whose output holds the even samples in the real and the odd
+ * samples in the imaginary part. The complex spectra of all channels are
+ * stored split into real and imaginary arrays as [index][channel], so
+ * every butterfly of the radix-2 stages runs over the channels in one
+ * loop the compiler vectorizes, and each twiddle is loaded once for the
+ * whole batch instead of once per channel and call. The channel count is
+ * padded to a multiple of 4 (1 stays scalar) and the stages are compiled
+ * for each width, so the channel loop has a fixed trip count.
+ *
+ * The result is unnormalized like kfr::dft_plan_real, and getSamples()
+ * only separates the sample ranges the caller reads. With setOutputs() the
+ * radix-2 stages are output-pruned to those ranges as well: the last
+ * stages skip the butterflies whose outputs no later stage reads, and
+ * butterflies with one read output compute only that one.
+ *
+ *
+ * \author Hilko Tondock
+ *
+ * \version  0.1
+ *
+ * \date   2023/03/31
+ *
+ * Contact: h.tondock@campus.tu-berlin.de
+ *
+ */
+
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#ifndef M_PI
+    #define M_PI 3.14159265358979323846
+#endif
+
+template <typename T>
+class BatchedIFFT
+{
+public:
+    // size is a power of two, maxChannels the largest batch
+    BatchedIFFT(int size, int maxChannels);
+
+    // Channels the batch of a channel count is padded to
+    static int getWidth(int channels) noexcept;
+
+    // Inverse of spectra[c][k * stride] for k in [0, size / 2] and c in [0, channels),
+    // the imaginary parts of DC and Nyquist are ignored
+    void execute(const std::complex<T>* const* spectra, int stride, int channels) noexcept;
+
+    // Only samples [0, count) and [size - count, size) are computed, count is even, size => all
+    void setOutputs(int count) noexcept;
+
+    // Copies samples [first, first + count) of every channel to frames[c] + first, first and count are even
+    void getSamples(T* const* frames, int first, int count, int channels) const noexcept;
+
+    int getSize() const noexcept;
+
+private:
+    int m_size;
+
+    int m_halfSize;
+
+    int m_width; // Padded channel count of the last batch, the stride of the batch arrays
+
+    int m_outputHalf; // Complex outputs [0, m_outputHalf) and [size / 2 - m_outputHalf, size / 2) are computed
+
+    std::vector<int> m_bitReversal;
+
+    std::vector<T> m_cos; // cos/sin of 2 pi n / size for n < size / 2
+    std::vector<T> m_sin;
+
+    std::vector<T> m_real; // [index][channel]
+    std::vector<T> m_imag;
+
+    template <int Width>
+    void transform(const std::complex<T>* const* spectra, int stride, int channels) noexcept;
+};
+
+template <typename T>
+inline int BatchedIFFT<T>::getSize() const noexcept { return m_size; }
+
+template <typename T>
+inline void BatchedIFFT<T>::setOutputs(int count) noexcept { m_outputHalf = count >= m_size ? m_halfSize : count / 2; }
+
+template <typename T>
+inline int BatchedIFFT<T>::getWidth(int channels) noexcept { return channels <= 1 ? 1 : (channels + 3) / 4 * 4; }
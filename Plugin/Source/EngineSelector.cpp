@@ -0,0 +1,56 @@
+#include "EngineSelector.hpp"
+
+EngineSelector::EngineSelector(int frameSize, int hopSize, int K)
+    : m_frameSize(frameSize),
+      m_hopSize(hopSize),
+      m_width(2 * (K / 2) + 1),
+      m_fftCost(static_cast<double>(FFT_COST_FACTOR) * (frameSize / 2) * std::log2(frameSize)),
+      m_sparseBinLimit(m_fftCost / (2.0 * SPARSE_SYNTHESIS_COST_FACTOR * hopSize)),
+      m_engine(Engine::Spectral)
+{
+}
+
+Engine EngineSelector::select(int partials, int channels, int numSamples) noexcept
+{
+    // The wavetable engine has one oscillator per partial
+    if (partials > TIMEDOMAIN_OSCILLATORS)
+    {
+        m_engine = Engine::Spectral;
+        return m_engine;
+    }
+
+    const double spectralCost = getSpectralCost(partials, channels, numSamples);
+    const double timeDomainCost = getTimeDomainCost(partials, channels, numSamples);
+
+    if (m_engine == Engine::Spectral && ENGINE_HYSTERESIS * timeDomainCost < spectralCost)
+        m_engine = Engine::TimeDomain;
+    else if (m_engine == Engine::TimeDomain && ENGINE_HYSTERESIS * spectralCost < timeDomainCost)
+        m_engine = Engine::Spectral;
+
+    return m_engine;
+}
+
+double EngineSelector::getSpectralCost(int partials, int channels, int numSamples) const noexcept
+{
+    // Partials occupy at most their own bins, few of them are synthesised directly instead of transformed
+    const double bins = static_cast<double>(partials) * m_width;
+    const double transformCost = bins < m_sparseBinLimit ? bins * 2.0 * SPARSE_SYNTHESIS_COST_FACTOR * m_hopSize : m_fftCost;
+    const double hopCost = channels * (transformCost + bins);
+
+    return hopCost * numSamples / m_hopSize;
+}
+
+double EngineSelector::getTimeDomainCost(int partials, int channels, int numSamples) const noexcept
+{
+    return static_cast<double>(partials) * numSamples * (TIMEDOMAIN_OSCILLATOR_COST + channels);
+}
+
+int EngineSelector::getCrossover(int channels, int numSamples) const noexcept
+{
+    int partials = 1;
+
+    while (partials < TIMEDOMAIN_OSCILLATORS && getSpectralCost(partials, channels, numSamples) >= getTimeDomainCost(partials, channels, numSamples))
+        ++partials;
+
+    return partials;
+}
@@ -0,0 +1,78 @@
+/**
+ * \class EngineSelector
+ *
+ *
+ * \brief Picks the cheaper of the IFFT and the TimeDomain engine per block.
+ *
+ * The wavetable engine costs one oscillator sample and one multiply-add per
+ * channel for every partial and sample, the spectral engine the splat and
+ * the channel transforms (or the direct synthesis of a sparse spectrum) per
+ * hop. Both are expressed in splat multiply-adds with the cost factors the
+ * Benchmark target measures, so select() compares them for the live partial
+ * count, channel count and block size. A switch needs the other engine to
+ * be ENGINE_HYSTERESIS times cheaper, so partial counts near the crossover
+ * do not toggle the engines block by block.
+ *
+ *
+ * \author Hilko Tondock
+ *
+ * \version  0.1
+ *
+ * \date   2023/03/31
+ *
+ * Contact: h.tondock@campus.tu-berlin.de
+ *
+ */
+
+#pragma once
+
+#include "IFFT.hpp"
+#include "TimeDomain.hpp"
+
+const int TIMEDOMAIN_OSCILLATOR_COST = 8; // Cost of one wavetable oscillator sample relative to one splat multiply-add, see Benchmark
+const double ENGINE_HYSTERESIS = 1.25; // Cost ratio the other engine has to beat before a switch
+
+enum class Engine
+{
+    Spectral = 0, // IFFT
+    TimeDomain    // Wavetable oscillators
+};
+
+class EngineSelector
+{
+public:
+    // Frame, hop and K of the IFFT the spectral costs are estimated for
+    EngineSelector(int frameSize, int hopSize, int K);
+
+    // Engine for the next block, starts with the spectral engine
+    Engine select(int partials, int channels, int numSamples) noexcept;
+
+    Engine getEngine() const noexcept;
+
+    void setEngine(Engine engine) noexcept;
+
+    // Costs of one block in splat multiply-adds
+    double getSpectralCost(int partials, int channels, int numSamples) const noexcept;
+
+    double getTimeDomainCost(int partials, int channels, int numSamples) const noexcept;
+
+    // Partial count from which the spectral engine is cheaper, ignoring the hysteresis
+    int getCrossover(int channels, int numSamples) const noexcept;
+
+private:
+    int m_frameSize;
+
+    int m_hopSize;
+
+    int m_width;
+
+    double m_fftCost;
+
+    double m_sparseBinLimit;
+
+    Engine m_engine;
+};
+
+inline Engine EngineSelector::getEngine() const noexcept { return m_engine; }
+
+inline void EngineSelector::setEngine(Engine engine) noexcept { m_engine = engine; }
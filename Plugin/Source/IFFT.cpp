@@ -7,7 +7,9 @@
  * 
  */
 
-IFFT::IFFT (int ifftSize,
+template <typename T>
+IFFT<T>::IFFT (int ifftSize,
+            int overlapFactor,
             WindowType windowType,
             int oversamplingFactor,
             int K)
@@ -17,240 +19,1366 @@ IFFT::IFFT (int ifftSize,
       m_channels(AC),  
       m_frameSize(ifftSize),
       m_halfFrameSize(ifftSize / 2),
-      m_hopSize(ifftSize / 4),
+      m_overlapFactor(overlapFactor == 2 || overlapFactor == 8 ? overlapFactor : 4),
+      m_hopSize(ifftSize / m_overlapFactor),
+      m_shortHop(m_hopSize),
+      m_longHop(m_overlapFactor == 8 ? 2 * m_hopSize : m_hopSize),
+      m_previousHop(m_hopSize),
+      m_readSamples(m_hopSize),
+      m_adaptiveHop(false),
+      m_scenePartials(-1),
       m_oversamplingFactor(oversamplingFactor),
       m_K(K/2),
       m_motif(std::move(windowType), m_frameSize, m_oversamplingFactor, m_K),
-      m_motifMiddleIndex(m_motif.getMiddleIndex()),
+      m_partialCapacity(0),
+      m_phasorHops(0),
+      m_cacheHits(0),
+      m_cachePartials(0),
+      m_motifNoiseFloor(0.0),
+      m_motifBinTotal(0),
+      m_cullingThreshold(0.0),
+      m_maskingThreshold(0.0),
+      m_culledPartials(0),
+      m_guardBins(0),
+      m_vectorizedSplat(SpectralSplat<T>::isVectorized()),
+      m_binSortedSplat(true),
+      m_layout(SpectrumLayout::ChannelMajor),
+      m_blockChannels(AC),
+      m_rowStride(2 * m_K + 2),
+      m_dirtyLow(0),
+      m_dirtyHigh(0),
+      m_sparseBinLimit(0),
+      m_sparseHop(false),
+      m_sparseBinCount(0),
       m_sampleCount(0),
-      m_plan(m_frameSize)
+      m_plan(m_frameSize),
+      m_pairPlan(m_frameSize),
+      m_temps(1, kfr::univector<kfr::u8>(std::max(m_plan.temp_size, m_pairPlan.temp_size))),
+      m_pairBuffers(1),
+      m_channelPairing(false),
+      m_pairCount(0),
+      m_batchedHop(false),
+      m_directionBucketing(false),
+      m_angularError(0.0),
+      m_bucketCount(0),
+      m_currentFrame(0),
+      m_outputs(nullptr),
+      m_outputGain(nullptr),
+      m_outputSamples(0),
+      m_splatInput(nullptr),
+      m_splatPartitionCount(1),
+      m_parallelSplatThreshold(PARALLEL_SPLAT_CROSSOVER)
 {
-    m_phases.resize(10000, 0.0);
+    // The two window slices the overlap-add uses, for the short and the long hop of the adaptive hop
+    createSynthWindow(m_shortHop, m_synthWindowHead, m_synthWindowTail);
+    createSynthWindow(m_longHop, m_longWindowHead, m_longWindowTail);
 
-    m_synthWindow.resize(m_frameSize);
-    createSynthWindow();
+    m_motifCoefficients.resize(2 * m_K + 1, std::complex<T>(0.0, 0.0));
+    m_motifThresholds.resize(m_K + 1, 0.0);
+    m_binBands.resize(m_halfFrameSize + 1, 0);
+    m_binCounts.resize(m_halfFrameSize + 1, 0);
+    createMaskingBands();
+
+    // At least m_K guard bins, rounded up to whole alignment units
+    const int alignmentBins = SPECTRUM_ALIGNMENT_BYTES / static_cast<int>(sizeof(std::complex<T>));
+    m_guardBins = (m_K + alignmentBins - 1) / alignmentBins * alignmentBins;
+
+    // Direct synthesis of a bin costs two hops of multiply-adds per channel, the transform its butterflies
+    const long long fftCost = static_cast<long long>(FFT_COST_FACTOR) * m_halfFrameSize * static_cast<long long>(std::log2(m_frameSize));
+    m_sparseBinLimit = static_cast<int>(fftCost / (2LL * SPARSE_SYNTHESIS_COST_FACTOR * m_hopSize));
+
+    m_binOccupied.resize(m_halfFrameSize + 1, 0);
+    m_sparseBins.resize(m_halfFrameSize + 1, 0);
+    m_sparseIndices.resize(m_halfFrameSize + 1, 0);
+    m_sparseReal.resize((m_halfFrameSize + 1) * AC, 0.0);
+    m_sparseImag.resize((m_halfFrameSize + 1) * AC, 0.0);
+    m_sparseCos.resize(m_frameSize);
+    m_sparseSin.resize(m_frameSize);
+
+    for (int n = 0; n < m_frameSize; ++n)
+    {
+        m_sparseCos[n] = static_cast<T>(std::cos(2.0 * M_PI * n / m_frameSize));
+        m_sparseSin[n] = static_cast<T>(std::sin(2.0 * M_PI * n / m_frameSize));
+    }
+
+    // Largest power of two channel count whose bins fit the L1 budget
+    while (m_blockChannels > 1 && m_blockChannels * (m_halfFrameSize + 1 + 2 * m_guardBins) * static_cast<int>(sizeof(std::complex<T>)) > SPECTRUM_BLOCK_BYTES)
+        m_blockChannels /= 2;
+
+    m_blockSize = m_blockChannels * (m_halfFrameSize + 1 + 2 * m_guardBins);
+    m_interleavedSpectrum.resize((AC / m_blockChannels) * m_blockSize, std::complex<T>(0.0, 0.0));
 
-    for (auto& channel: m_spectrumArray)
-        channel.resize(m_halfFrameSize + 1, std::complex<double> (0.0, 0.0));
-        
     for (auto& channel: bufferArray)
         channel.resize(m_hopSize);
-
-    for (auto& channel: m_overlapBufferArray)
-        channel.resize(m_hopSize, 0.0);
     // Performance: https://stackoverflow.com/questions/8848575/fastest-way-to-reset-every-value-of-stdvectorint-to-0
 
     //////////////// KFR ////////////////
     for (int i = 0; i < m_channels; ++i)
     {
-        m_ifftSpectrumArray[i].resize(m_halfFrameSize + 1, kfr::complex(0.0, 0.0));
-        m_ifftSamplesArray[i].resize(m_frameSize, 0.0);
+        m_ifftSpectrumArray[i].resize(m_halfFrameSize + 1 + 2 * m_guardBins, kfr::complex<T>(0.0, 0.0));
+        m_ifftSamplesArray[0][i].resize(m_frameSize, 0.0);
+        m_ifftSamplesArray[1][i].resize(m_frameSize, 0.0);
     }
+
+    m_pairBuffers[0][0].resize(m_frameSize, kfr::complex<T>(0.0, 0.0));
+    m_pairBuffers[0][1].resize(m_frameSize, kfr::complex<T>(0.0, 0.0));
+
+    // The splat writes straight into the aligned IFFT input
+    static_assert(sizeof(kfr::complex<T>) == sizeof(std::complex<T>), "kfr::complex and std::complex must share their layout");
+
+    for (int c = 0; c < AC; ++c)
+        m_spectrumRows[c] = reinterpret_cast<std::complex<T>*>(m_ifftSpectrumArray[c].data() + m_guardBins);
 }
 
-IFFT::~IFFT() {}
+template <typename T>
+IFFT<T>::~IFFT() {}
 
-void IFFT::createSpectrum(const std::vector<Partial<float>>& partials) noexcept
+template <typename T>
+void IFFT<T>::createSpectrum(const std::vector<Partial<float>>& partials) noexcept
 {
-    double binRealLocation;
-    int binFrameLocation;
-    double binRemainder;
-    double currentAmplitude;
-    double currentFrequency;
-    double phaseOffset;
-    double currentPhase;
-    double real;
-    double imag;
-    double cosPhase;
-    double sinPhase;
-    double amplitudeFactor;
-    //std::fill (m_spectrum.begin(), m_spectrum.end(), std::complex<double> (0.0, 0.0));
-    for (auto& channel: m_spectrumArray)
-    {
-        std::fill(channel.begin(), channel.end(), std::complex<double>(0.0, 0.0));
+    const int partialCount = static_cast<int>(partials.size());
+
+    if (partialCount > m_partialCapacity)
+        setMaxPartials(std::max(partialCount, 2 * m_partialCapacity));
+
+    m_phasorHops = (m_phasorHops + 1) % PHASOR_RENORMALISATION_HOPS;
+    m_previousHop = m_hopSize;
+    m_hopSize = m_adaptiveHop && isStationary(partials) ? m_longHop : m_shortHop;
+    m_cachePartials = partialCount;
+    m_motifBinTotal = isSelectingPartials() ? selectPartials(partials) : static_cast<long long>(partialCount) * (2 * m_K + 1);
+
+    m_bucketCount = m_directionBucketing ? assignDirectionBuckets(partials) : 0;
+    m_sparseHop = false;
+
+    const int partitions = getSplatPartitions(partialCount);
+
+    // The other paths overwrite the whole KFR input, so the next channel-major hop clears all of it
+    if (m_bucketCount > 0 || m_layout == SpectrumLayout::Interleaved || partitions > 1)
+    {
+        m_dirtyLow = 0;
+        m_dirtyHigh = m_halfFrameSize + 1;
+    }
+
+    if (m_bucketCount > 0)
+    {
+        createSpectrumBuckets(partials);
+        return;
+    }
+
+    if (m_layout == SpectrumLayout::Interleaved)
+    {
+        createSpectrumInterleaved(partials);
+        return;
+    }
+
+    if (partitions > 1)
+    {
+        createSpectrumParallel(partials, partitions);
+        return;
+    }
+
+    // Only the bins the last hop wrote can be non-zero
+    for (int c = 0; c < m_channels; ++c)
+    {
+        std::fill(m_spectrumRows[c] + m_dirtyLow, m_spectrumRows[c] + m_dirtyHigh, std::complex<T>(0.0, 0.0));
     }
     
     //for (int i = 0; i < m_frequencies.size(); i++)
-    
-    for (int i = 0; i < static_cast<int>(partials.size()); i++)
+
+    m_cacheHits = splatPartials(partials, 0, partialCount, m_spectrumRows.data(), m_motifCoefficients.data(), m_weights.data(), m_binCounts.data());
+
+    updateOccupancy(partialCount);
+}
+
+template <typename T>
+void IFFT<T>::updateOccupancy(int partialCount) noexcept
+{
+    // Bins of the partials the splat rendered, folded bins stay inside [0, bin + K] and [bin - K, N / 2]
+    auto inBand = [this](int i) { return m_binLocations[i] > 0 && m_binLocations[i] < m_halfFrameSize - 1 && m_motifBins[i] >= 0; };
+
+    int low = m_halfFrameSize + 1;
+    int high = 0;
+
+    for (int i = 0; i < partialCount; ++i)
     {
-        currentAmplitude = 0.5 * partials[i].amplitude;
-        currentFrequency = partials[i].frequency;
-        binRealLocation = currentFrequency * m_frameSize * m_T;
-        binFrameLocation = (int)floor (binRealLocation + 0.5);
-        binRemainder = floor (binRealLocation + 0.5) - binRealLocation;
+        if (inBand(i))
+        {
+            low = std::min(low, std::max(0, m_binFrameLocations[i] - m_K));
+            high = std::max(high, std::min(m_halfFrameSize, m_binFrameLocations[i] + m_K) + 1);
+        }
+    }
 
-        m_phases[i] = std::fmod(m_phases[i] + 2 * M_PI * currentFrequency * 0.5 * m_hopSize * m_T, 2 * M_PI);
-        currentPhase = m_phases[i];
-        m_phases[i] = std::fmod(m_phases[i] + 2 * M_PI * currentFrequency * 0.5 * m_hopSize * m_T, 2 * M_PI);
-        
-        //m_phases[i] = std::fmod(m_phases[i] + 2 * M_PI * currentFrequency * m_hopSize * m_T, 2 * M_PI);
+    m_dirtyLow = std::min(low, high);
+    m_dirtyHigh = high;
 
-        cosPhase = cos(currentPhase);
-        sinPhase = sin(currentPhase);
+    int bins = 0;
 
-        if ((binRealLocation >= m_K + 1) && (binRealLocation < m_halfFrameSize - m_K))
+    if (m_dirtyHigh - m_dirtyLow < m_sparseBinLimit)
+    {
+        // A narrow range is synthesised as a whole, bins in gaps between partials are zero
+        for (int bin = m_dirtyLow; bin < m_dirtyHigh; ++bin)
+            m_sparseBins[bins++] = bin;
+    }
+    else if (static_cast<long long>(partialCount) * (2 * m_K + 1) < m_sparseBinLimit)
+    {
+        // Few partials spread over the spectrum, only their own bins are synthesised
+        for (int i = 0; i < partialCount; ++i)
         {
-            for (int j = -m_K; j <= m_K; ++j)
+            if (inBand(i))
             {
-                // TODO: Use the symmetry of the motif?
-                amplitudeFactor = currentAmplitude * m_motif.getRealValueAtIndex((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex); 
-                real = amplitudeFactor * cosPhase;
-                imag = amplitudeFactor * sinPhase;
-                //real = currentAmplitude 
-                //       * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                //       * cosPhase;
-                //imag = currentAmplitude 
-                //       * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                //       * sinPhase;
+                const int first = std::max(0, m_binFrameLocations[i] - m_K);
+                const int last = std::min(m_halfFrameSize, m_binFrameLocations[i] + m_K);
+                std::fill(m_binOccupied.begin() + first, m_binOccupied.begin() + last + 1, 1);
+            }
+        }
 
-                for (int c = 0; c < m_channels; ++c)    
-                    m_spectrumArray[c][binFrameLocation + j] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                     partials[i].bFormat[c] * imag);
+        for (int bin = m_dirtyLow; bin < m_dirtyHigh; ++bin)
+        {
+            m_sparseBins[bins] = bin;
+            bins += m_binOccupied[bin];
+            m_binOccupied[bin] = 0;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    m_sparseBinCount = bins;
+    m_sparseHop = true;
+}
+
+template <typename T>
+void IFFT<T>::synthesizeSparse() noexcept
+{
+    // Real inverse DFT of the occupied bins: DC and Nyquist count once and only with their real part,
+    // every other bin twice for its conjugate mirror
+    for (int b = 0; b < m_sparseBinCount; ++b)
+    {
+        const int bin = m_sparseBins[b];
+        const bool edge = bin == 0 || bin == m_halfFrameSize;
+        const T weight = edge ? static_cast<T>(1.0) : static_cast<T>(2.0);
+
+        for (int c = 0; c < m_channels; ++c)
+        {
+            m_sparseReal[b * AC + c] = weight * m_spectrumRows[c][bin].real();
+            m_sparseImag[b * AC + c] = edge ? static_cast<T>(0.0) : -weight * m_spectrumRows[c][bin].imag();
+        }
+    }
+
+    // Only the two ends the overlap-add reads are synthesised, the twiddles are shared by all channels
+    const int ranges[2] = { 0, m_frameSize - m_readSamples };
+    std::array<T, AC> sum;
+
+    for (int range: ranges)
+    {
+        for (int b = 0; b < m_sparseBinCount; ++b)
+            m_sparseIndices[b] = static_cast<int>(static_cast<long long>(m_sparseBins[b]) * range % m_frameSize);
+
+        for (int n = range; n < range + m_readSamples; ++n)
+        {
+            sum.fill(0.0);
+
+            for (int b = 0; b < m_sparseBinCount; ++b)
+            {
+                const int index = m_sparseIndices[b];
+                const T cosine = m_sparseCos[index];
+                const T sine = m_sparseSin[index];
+                const T* real = m_sparseReal.data() + b * AC;
+                const T* imag = m_sparseImag.data() + b * AC;
+
+                for (int c = 0; c < AC; ++c)
+                    sum[c] += real[c] * cosine + imag[c] * sine;
+
+                const int next = index + m_sparseBins[b];
+                m_sparseIndices[b] = next >= m_frameSize ? next - m_frameSize : next;
             }
+
+            for (int c = 0; c < m_channels; ++c)
+                m_ifftSamplesArray[m_currentFrame][c][n] = sum[c];
+        }
+    }
+}
+
+template <typename T>
+void IFFT<T>::createSpectrumParallel(const std::vector<Partial<float>>& partials, int partitions) noexcept
+{
+    m_splatInput = &partials;
+    m_splatPartitionCount = partitions;
+
+    m_workerPool->run(&IFFT<T>::splatPartitionTask, this, partitions);
+
+    m_cacheHits = 0;
+
+    for (int p = 0; p < partitions; ++p)
+        m_cacheHits += m_splatPartitions[p].cacheHits;
+
+    // Reduction after all partitions are done, every channel adds them up in partition order
+    m_workerPool->run(&IFFT<T>::reduceChannelTask, this, m_channels);
+
+    m_splatInput = nullptr;
+}
+
+template <typename T>
+void IFFT<T>::splatPartition(int partition) noexcept
+{
+    const int partialCount = static_cast<int>(m_splatInput->size());
+    const int begin = static_cast<int>(static_cast<long long>(partition) * partialCount / m_splatPartitionCount);
+    const int end = static_cast<int>(static_cast<long long>(partition + 1) * partialCount / m_splatPartitionCount);
+
+    SplatPartition& state = m_splatPartitions[partition];
+
+    for (int c = 0; c < m_channels; ++c)
+        std::fill(state.rows[c], state.rows[c] + m_halfFrameSize + 1, std::complex<T>(0.0, 0.0));
+
+    state.cacheHits = splatPartials(*m_splatInput, begin, end, state.rows.data(), state.motifCoefficients.data(), state.weights.data(), state.binCounts.data());
+}
+
+template <typename T>
+void IFFT<T>::reduceChannel(int channel) noexcept
+{
+    T* destination = reinterpret_cast<T*>(m_spectrumRows[channel]);
+
+    for (int p = 1; p < m_splatPartitionCount; ++p)
+        SpectralSplat<T>::accumulate(destination, reinterpret_cast<const T*>(m_splatPartitions[p].rows[channel]), static_cast<T>(1.0), 2 * (m_halfFrameSize + 1));
+}
+
+template <typename T>
+void IFFT<T>::splatPartitionTask(void* context, int partition, int) noexcept
+{
+    static_cast<IFFT<T>*>(context)->splatPartition(partition);
+}
+
+template <typename T>
+void IFFT<T>::reduceChannelTask(void* context, int channel, int) noexcept
+{
+    static_cast<IFFT<T>*>(context)->reduceChannel(channel);
+}
+
+template <typename T>
+int IFFT<T>::getSplatPartitions(int partialCount) noexcept
+{
+    if (!m_workerPool || partialCount < m_parallelSplatThreshold)
+        return 1;
+
+    // Depends on the partial count only, so the sum is the same for every thread count
+    return std::min(MAX_SPLAT_PARTITIONS, (partialCount + SPLAT_PARTITION_SIZE - 1) / SPLAT_PARTITION_SIZE);
+}
+
+template <typename T>
+int IFFT<T>::splatPartials(const std::vector<Partial<float>>& partials,
+                           int begin,
+                           int end,
+                           std::complex<T>* const* rows,
+                           std::complex<T>* coefficients,
+                           T* weightBuffer,
+                           int* binCounts) noexcept
+{
+    advancePhases(partials, begin, end);
+
+    const int hits = refreshCoefficients(partials, begin, end);
+    const int width = 2 * m_K + 1;
+    const int count = orderPartials(begin, end, binCounts);
+
+    int binFrameLocation;
+    T real;
+    T imag;
+    T cosPhase;
+    T sinPhase;
+    T amplitudeFactor;
+
+    // The rows have m_guardBins on both sides, so every partial is one contiguous run of
+    // bins. Bins beyond DC and Nyquist are folded back afterwards, see foldGuardBins()
+    for (int n = begin; n < begin + count; n++)
+    {
+        const int i = m_splatOrder[n];
+        binFrameLocation = m_binFrameLocations[i];
+        const T* scaledMotif = m_scaledMotifs.data() + i * width;
+
+        const int bins = m_motifBins[i];
+
+        cosPhase = m_centreReal[i];
+        sinPhase = m_centreImag[i];
+
+        for (int j = -bins; j <= bins; ++j)
+        {
+            amplitudeFactor = scaledMotif[j + m_K]; 
+            coefficients[j + m_K] = std::complex<T>(amplitudeFactor * cosPhase, amplitudeFactor * sinPhase);
         }
-        else if ((binRealLocation > 0) && (binRealLocation < m_K + 1))
+
+        if (m_vectorizedSplat)
         {
-            for (int j = -m_K; j <= m_K; ++j)
+            const T* weights;
+
+            if constexpr (std::is_same<T, float>::value)
+            {
+                weights = partials[i].bFormat.data();
+            }
+            else
             {
-                if (binFrameLocation + j < 0)
-                {
-                    real = currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex) 
-                           * cosPhase;
-                    imag = -1 * currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex) 
-                           * sinPhase;
-
-                    for (int c = 0; c < m_channels; ++c)    
-                        m_spectrumArray[c][-1 * (binFrameLocation + j)] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                                partials[i].bFormat[c] * imag);
-                }
-                else if (binFrameLocation + j == 0)
-                {
-                    real = 2.0 * currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex) 
-                           * cosPhase;
-                    imag = 0.0;
-
-                    for (int c = 0; c < m_channels; ++c)    
-                        m_spectrumArray[c][binFrameLocation + j] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                         partials[i].bFormat[c] * imag);
-                }
-                else
-                {
-                    real = currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                           * cosPhase;
-                    imag = currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                           * sinPhase;
-
-                    for (int c = 0; c < m_channels; ++c)    
-                        m_spectrumArray[c][binFrameLocation + j] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                         partials[i].bFormat[c] * imag);
-                }
+                std::copy(partials[i].bFormat.begin(), partials[i].bFormat.begin() + m_channels, weightBuffer);
+                weights = weightBuffer;
             }
+
+            SpectralSplat<T>::splatPartial(rows, binFrameLocation - bins, 
+                                           coefficients + m_K - bins, 2 * bins + 1, 
+                                           weights, m_channels);
         }
-        else if ((binRealLocation >= m_halfFrameSize - m_K) && (binRealLocation < m_halfFrameSize - 1))
+        else
         {
-            for (int j = -m_K; j <= m_K; ++j)
+            for (int j = -bins; j <= bins; ++j)
             {
-                if (binFrameLocation + j > m_halfFrameSize)
-                {
-                    real = currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                           * cosPhase;
-                    imag = -1 * currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex) 
-                           * sinPhase;
-
-                    for (int c = 0; c < m_channels; ++c)    
-                        m_spectrumArray[c][m_frameSize - (binFrameLocation + j)] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                                         partials[i].bFormat[c] * imag);
-                }
-                else if (binFrameLocation + j == m_halfFrameSize)
-                {
-                    real = 2.0 * currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                           * cosPhase;
-                    imag = 0.0;
-
-                    for (int c = 0; c < m_channels; ++c)    
-                        m_spectrumArray[c][binFrameLocation + j] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                         partials[i].bFormat[c] * imag);
-                }
-                else
-                {
-                    real = currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                           * cosPhase;
-                    imag = currentAmplitude 
-                           * m_motif.getRealValueAtIndex ((int)((binRemainder + j) * m_oversamplingFactor) + m_motifMiddleIndex)
-                           * sinPhase;
-
-                    for (int c = 0; c < m_channels; ++c)    
-                        m_spectrumArray[c][binFrameLocation + j] += std::complex<double>(partials[i].bFormat[c] * real, 
-                                                                                         partials[i].bFormat[c] * imag);
-                }
+                real = coefficients[j + m_K].real();
+                imag = coefficients[j + m_K].imag();
+
+                for (int c = 0; c < m_channels; ++c)    
+                    rows[c][binFrameLocation + j] += std::complex<T>(partials[i].bFormat[c] * real, 
+                                                                     partials[i].bFormat[c] * imag);
             }
         }
+    }
+
+    for (int c = 0; c < m_channels; ++c)
+        foldGuardBins(rows[c], 1);
+
+    return hits;
+}
+   
+template <typename T>
+int IFFT<T>::orderPartials(int begin, int end, int* binCounts) noexcept
+{
+    // Only in-band partials that were not culled are splatted
+    auto splatted = [this](int i) { return m_binLocations[i] > 0 && m_binLocations[i] < m_halfFrameSize - 1 && m_motifBins[i] >= 0; };
+
+    int position = begin;
+
+    if (!m_binSortedSplat)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            m_splatOrder[position] = i;
+            position += splatted(i);
+        }
+
+        return position - begin;
+    }
+
+    // Counting sort by frame bin, stable so partials sharing a bin keep their order.
+    // The phase state stays indexed by partial, only the visiting order changes
+    std::fill(binCounts, binCounts + m_halfFrameSize + 1, 0);
+
+    for (int i = begin; i < end; ++i)
+    {
+        if (splatted(i))
+            ++binCounts[m_binFrameLocations[i]];
+    }
+
+    for (int bin = 0; bin <= m_halfFrameSize; ++bin)
+    {
+        const int count = binCounts[bin];
+        binCounts[bin] = position;
+        position += count;
+    }
+
+    for (int i = begin; i < end; ++i)
+    {
+        if (splatted(i))
+            m_splatOrder[binCounts[m_binFrameLocations[i]]++] = i;
+    }
+
+    return position - begin;
+}
+
+template <typename T>
+void IFFT<T>::foldGuardBins(std::complex<T>* row, int stride) noexcept
+{
+    // Bin -m mirrors to m and N / 2 + m to N / 2 - m with conjugated phase. DC and Nyquist
+    // are their own mirrors, so they keep twice their real part
+    const int nyquist = m_halfFrameSize * stride;
+
+    for (int m = stride; m <= m_K * stride; m += stride)
+    {
+        row[m] += std::conj(row[-m]);
+        row[nyquist - m] += std::conj(row[nyquist + m]);
+        row[-m] = std::complex<T>(0.0, 0.0);
+        row[nyquist + m] = std::complex<T>(0.0, 0.0);
+    }
+
+    row[0] = std::complex<T>(2 * row[0].real(), 0.0);
+    row[nyquist] = std::complex<T>(2 * row[nyquist].real(), 0.0);
+}
+
+template <typename T>
+void IFFT<T>::setMaxPartials(int partials)
+{
+    if (partials <= m_partialCapacity)
+        return;
+
+    m_partialCapacity = partials;
+
+    m_phasorReal.resize(partials, 1.0);
+    m_phasorImag.resize(partials, 0.0);
+    m_centreReal.resize(partials, 1.0);
+    m_centreImag.resize(partials, 0.0);
+    m_rotationReal.resize(partials, 1.0);
+    m_rotationImag.resize(partials, 0.0);
+    m_rotationFrequencies.resize(partials, -1.0f);
+
+    m_cachedAmplitudes.resize(partials, 0.0f);
+    m_cachedFrequencies.resize(partials, -1.0f);
+    m_binLocations.resize(partials, 0.0);
+    m_binFrameLocations.resize(partials, 0);
+    m_scaledMotifs.resize(partials * (2 * m_K + 1), 0.0);
+    m_motifBins.resize(partials, m_K);
+    m_splatOrder.resize(partials, 0);
+
+    if (m_adaptiveHop)
+        m_scene.resize(partials * (2 + AC), 0.0f);
+
+    m_rowFirstBins.resize(partials, 0);
+    m_rowWidths.resize(partials, 0);
+    m_rows.resize(partials * m_rowStride, std::complex<T>(0.0, 0.0));
+    m_partialBuckets.resize(partials, 0);
+}
+
+template <typename T>
+void IFFT<T>::advancePhases(const std::vector<Partial<float>>& partials, int begin, int end) noexcept
+{
+    // Only a new frequency needs a new rotation, the only transcendental calls left per partial
+    const double halfHopAngle = M_PI * m_shortHop * static_cast<double>(m_T);
+
+    for (int i = begin; i < end; ++i)
+    {
+        if (partials[i].frequency != m_rotationFrequencies[i])
+        {
+            const double angle = halfHopAngle * partials[i].frequency;
+            m_rotationReal[i] = static_cast<T>(std::cos(angle));
+            m_rotationImag[i] = static_cast<T>(std::sin(angle));
+            m_rotationFrequencies[i] = partials[i].frequency;
+        }
+    }
+
+    T* phasorReal = m_phasorReal.data();
+    T* phasorImag = m_phasorImag.data();
+    T* centreReal = m_centreReal.data();
+    T* centreImag = m_centreImag.data();
+    const T* rotationReal = m_rotationReal.data();
+    const T* rotationImag = m_rotationImag.data();
+
+    // Half a hop to the frame centre and half a hop past it, independent per partial so it vectorizes
+    if (m_hopSize == m_shortHop && m_previousHop == m_shortHop)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const T real = phasorReal[i] * rotationReal[i] - phasorImag[i] * rotationImag[i];
+            const T imag = phasorReal[i] * rotationImag[i] + phasorImag[i] * rotationReal[i];
+
+            centreReal[i] = real;
+            centreImag[i] = imag;
+            phasorReal[i] = real * rotationReal[i] - imag * rotationImag[i];
+            phasorImag[i] = real * rotationImag[i] + imag * rotationReal[i];
+        }
+    }
+    else
+    {
+        // A long hop rotates by the square of the short rotation. When the hop changes, the phasor half the
+        // previous hop past the last centre first moves to half the current hop past it: +-half a short hop
+        const bool longHop = m_hopSize != m_shortHop;
+        const T transition = static_cast<T>((m_hopSize - m_previousHop) / m_shortHop);
+
+        for (int i = begin; i < end; ++i)
+        {
+            const T halfReal = rotationReal[i];
+            const T halfImag = rotationImag[i];
+            const T rotReal = longHop ? halfReal * halfReal - halfImag * halfImag : halfReal;
+            const T rotImag = longHop ? 2 * halfReal * halfImag : halfImag;
+            const T startReal = transition != 0 ? phasorReal[i] * halfReal - phasorImag[i] * transition * halfImag : phasorReal[i];
+            const T startImag = transition != 0 ? phasorReal[i] * transition * halfImag + phasorImag[i] * halfReal : phasorImag[i];
+
+            const T real = startReal * rotReal - startImag * rotImag;
+            const T imag = startReal * rotImag + startImag * rotReal;
+
+            centreReal[i] = real;
+            centreImag[i] = imag;
+            phasorReal[i] = real * rotReal - imag * rotImag;
+            phasorImag[i] = real * rotImag + imag * rotReal;
+        }
+    }
 
-        //m_phases[i] = std::fmod(currentPhase + 2 * M_PI * currentFrequency * 0.5 * m_hopSize * m_T, 2 * M_PI);
+    // Rounding lets the magnitude drift, one Newton step towards 1 / |phasor| pulls it back
+    if (m_phasorHops == 0)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            const T scale = static_cast<T>(0.5) * (3 - (phasorReal[i] * phasorReal[i] + phasorImag[i] * phasorImag[i]));
+            phasorReal[i] *= scale;
+            phasorImag[i] *= scale;
+        }
+    }
+}
+
+template <typename T>
+int IFFT<T>::refreshCoefficients(const std::vector<Partial<float>>& partials, int begin, int end) noexcept
+{
+    const int width = 2 * m_K + 1;
+    int hits = 0;
+
+    for (int i = begin; i < end; ++i)
+    {
+        // The direction is applied by the splat, so only amplitude and frequency invalidate an entry
+        if (partials[i].amplitude == m_cachedAmplitudes[i] && partials[i].frequency == m_cachedFrequencies[i])
+        {
+            ++hits;
+            continue;
+        }
+
+        const T currentAmplitude = static_cast<T>(0.5) * partials[i].amplitude;
+        const T currentFrequency = partials[i].frequency;
+        const T binRealLocation = currentFrequency * m_frameSize * m_T;
+        const T binRemainder = floor (binRealLocation + static_cast<T>(0.5)) - binRealLocation;
+        T* scaledMotif = m_scaledMotifs.data() + i * width;
+
+        m_motif.getCoefficients(binRemainder, scaledMotif);
+
+        for (int j = 0; j < width; ++j)
+            scaledMotif[j] = currentAmplitude * scaledMotif[j];
+
+        m_binLocations[i] = binRealLocation;
+        m_binFrameLocations[i] = (int)floor (binRealLocation + static_cast<T>(0.5));
+        m_cachedAmplitudes[i] = partials[i].amplitude;
+        m_cachedFrequencies[i] = partials[i].frequency;
+    }
+
+    return hits;
+}
+
+template <typename T>
+long long IFFT<T>::selectPartials(const std::vector<Partial<float>>& partials) noexcept
+{
+    const int partialCount = static_cast<int>(partials.size());
+    const T binScale = m_frameSize * m_T;
+
+    // Level at the W channel, so the 1 / distance attenuation counts
+    auto level = [&partials](int i) { return std::abs(partials[i].amplitude * partials[i].bFormat[0]); };
+    auto band = [this, binScale, &partials](int i) { return m_binBands[std::max(0, std::min(static_cast<int>(partials[i].frequency * binScale + static_cast<T>(0.5)), m_halfFrameSize))]; };
+
+    if (m_maskingThreshold > 0)
+    {
+        m_bandLevels.fill(0.0);
+
+        for (int i = 0; i < partialCount; ++i)
+            m_bandLevels[band(i)] = std::max(m_bandLevels[band(i)], static_cast<T>(level(i)));
+    }
+
+    T energy = 0.0;
+    m_culledPartials = 0;
+
+    for (int i = 0; i < partialCount; ++i)
+    {
+        const T partialLevel = level(i);
+        const bool culled = partialLevel < m_cullingThreshold || (m_maskingThreshold > 0 && partialLevel < m_maskingThreshold * m_bandLevels[band(i)]);
+
+        m_motifBins[i] = culled ? -1 : m_K;
+        m_culledPartials += culled;
+        energy += culled ? static_cast<T>(0.0) : partialLevel * partialLevel;
+    }
+
+    if (m_motifNoiseFloor == 0)
+        return static_cast<long long>(partialCount - m_culledPartials) * (2 * m_K + 1);
+
+    // The truncation errors of the partials add up in energy, so a partial whose error stays below
+    // the floor times the RMS partial level keeps the sum below the floor times the signal
+    const T noiseFloor = m_motifNoiseFloor * std::sqrt(energy / std::max(1, partialCount - m_culledPartials));
+
+    for (int k = 0; k < m_K; ++k)
+        m_motifThresholds[k] = noiseFloor / std::max(m_motif.getTruncationError(k), std::numeric_limits<T>::min());
+
+    m_motifThresholds[m_K] = std::numeric_limits<T>::infinity();
+
+    long long total = 0;
+
+    for (int i = 0; i < partialCount; ++i)
+    {
+        if (m_motifBins[i] < 0)
+            continue;
+
+        const T partialLevel = level(i);
+        int bins = 0;
+
+        while (partialLevel > m_motifThresholds[bins])
+            ++bins;
+
+        m_motifBins[i] = bins;
+        total += 2 * bins + 1;
+    }
+
+    return total;
+}
+
+template <typename T>
+void IFFT<T>::setMotifNoiseFloor(T decibels) noexcept
+{
+    m_motifNoiseFloor = decibels < 0 ? std::pow(static_cast<T>(10.0), decibels / 20) : static_cast<T>(0.0);
+    resetPartialSelection();
+}
+
+template <typename T>
+void IFFT<T>::setCullingThreshold(T decibels) noexcept
+{
+    m_cullingThreshold = std::pow(static_cast<T>(10.0), decibels / 20);
+    resetPartialSelection();
+}
+
+template <typename T>
+void IFFT<T>::setMaskingThreshold(T decibels) noexcept
+{
+    m_maskingThreshold = decibels < 0 ? std::pow(static_cast<T>(10.0), decibels / 20) : static_cast<T>(0.0);
+    resetPartialSelection();
+}
+
+template <typename T>
+void IFFT<T>::resetPartialSelection() noexcept
+{
+    // Without a selection pass every partial keeps the full motif
+    if (!isSelectingPartials())
+    {
+        std::fill(m_motifBins.begin(), m_motifBins.end(), m_K);
+        m_culledPartials = 0;
+    }
+}
+
+template <typename T>
+void IFFT<T>::createMaskingBands() noexcept
+{
+    // Bark scale after Zwicker and Terhardt
+    for (int bin = 0; bin <= m_halfFrameSize; ++bin)
+    {
+        const double frequency = bin / (m_frameSize * static_cast<double>(m_T));
+        const double bark = 13.0 * std::atan(0.00076 * frequency) + 3.5 * std::atan(std::pow(frequency / 7500.0, 2.0));
+        m_binBands[bin] = std::min(static_cast<int>(bark), MASKING_BANDS - 1);
+    }
+}
+
+template <typename T>
+float IFFT<T>::getMotifBinsPerPartial() noexcept
+{
+    return m_cachePartials > 0 ? static_cast<float>(m_motifBinTotal) / m_cachePartials : 0.0f;
+}
+
+template <typename T>
+void IFFT<T>::setMotifInterpolation(MotifInterpolation interpolation) noexcept
+{
+    m_motif.setInterpolation(interpolation);
+    std::fill(m_cachedFrequencies.begin(), m_cachedFrequencies.end(), -1.0f);
+}
+
+template <typename T>
+float IFFT<T>::getCoefficientCacheHitRate() noexcept
+{
+    return m_cachePartials > 0 ? static_cast<float>(m_cacheHits) / m_cachePartials : 0.0f;
+}
+
+template <typename T>
+void IFFT<T>::createSpectrumInterleaved(const std::vector<Partial<float>>& partials) noexcept
+{
+    const int partialCount = static_cast<int>(partials.size());
+    const int activeBlocks = (m_channels + m_blockChannels - 1) / m_blockChannels;
+    const int binStride = 2 * m_blockChannels;
+
+    advancePhases(partials, 0, partialCount);
+    m_cacheHits = refreshCoefficients(partials, 0, partialCount);
+
+    const int count = orderPartials(0, partialCount, m_binCounts.data());
+
+    for (int n = 0; n < count; ++n)
+        createMotifRow(m_splatOrder[n]);
+
+    std::fill(m_interleavedSpectrum.begin(), m_interleavedSpectrum.begin() + activeBlocks * m_blockSize, std::complex<T>(0.0, 0.0));
+
+    // All partials are splatted into one L1 sized block before moving on to the next
+    for (int b = 0; b < activeBlocks; ++b)
+    {
+        const int firstChannel = b * m_blockChannels;
+        const int blockChannels = std::min(m_blockChannels, m_channels - firstChannel);
+        T* block = reinterpret_cast<T*>(getInterleavedChannel(firstChannel));
+
+        for (int n = 0; n < count; ++n)
+        {
+            const int i = m_splatOrder[n];
+
+            for (int c = 0; c < blockChannels; ++c)
+            {
+                m_interleavedWeights[2 * c] = partials[i].bFormat[firstChannel + c];
+                m_interleavedWeights[2 * c + 1] = partials[i].bFormat[firstChannel + c];
+            }
+
+            SpectralSplat<T>::splatInterleaved(block + m_rowFirstBins[i] * binStride, binStride, 
+                                               m_interleavedWeights.data(), 
+                                               m_rows.data() + i * m_rowStride, m_rowWidths[i], 
+                                               2 * blockChannels);
+        }
+
+        for (int c = firstChannel; c < firstChannel + blockChannels; ++c)
+            foldGuardBins(getInterleavedChannel(c), m_blockChannels);
+    }
+}
+
+template <typename T>
+std::complex<T>* IFFT<T>::getInterleavedChannel(int channel) noexcept
+{
+    return m_interleavedSpectrum.data() + (channel / m_blockChannels) * m_blockSize + m_guardBins * m_blockChannels + channel % m_blockChannels;
+}
+
+template <typename T>
+void IFFT<T>::createMotifRow(int index) noexcept
+{
+    T binRealLocation = m_binLocations[index];
+    int binFrameLocation = m_binFrameLocations[index];
+    const T* scaledMotif = m_scaledMotifs.data() + index * (2 * m_K + 1);
+
+    T cosPhase = m_centreReal[index];
+    T sinPhase = m_centreImag[index];
+
+    std::complex<T>* row = m_rows.data() + index * m_rowStride;
+    int& firstBin = m_rowFirstBins[index];
+    int& width = m_rowWidths[index];
+    const int bins = m_motifBins[index];
+
+    // Every partial is one contiguous run of bins, the ones beyond DC and Nyquist land in the
+    // guard bins and are folded back by foldGuardBins(). Culled partials get no row
+    if (bins < 0 || binRealLocation <= 0 || binRealLocation >= m_halfFrameSize - 1)
+    {
+        width = 0;
+        return;
+    }
+
+    firstBin = binFrameLocation - bins;
+    width = 2 * bins + 1;
+
+    for (int j = -bins; j <= bins; ++j)
+    {
+        T amplitudeFactor = scaledMotif[j + m_K];
+        row[j + bins] = std::complex<T>(amplitudeFactor * cosPhase, amplitudeFactor * sinPhase);
     }
 }
    
-void IFFT::IFFTprocess() noexcept
+template <typename T>
+int IFFT<T>::assignDirectionBuckets(const std::vector<Partial<float>>& partials) noexcept
 {
-    for (int i = 0; i < m_channels; ++i)
+    const int partialCount = static_cast<int>(partials.size());
+    int buckets = 0;
+
+    for (int i = 0; i < partialCount; ++i)
     {
-        for (int j = 0; j < m_halfFrameSize + 1; ++j)
+        // The bucket spectra are weighted by W, so partials without W add nothing and join no bucket
+        if (partials[i].bFormat[0] == 0)
+        {
+            m_partialBuckets[i] = -1;
+            continue;
+        }
+
+        std::array<long long, 2> key;
+
+        if (m_angularError > 0)
+        {
+            key[0] = std::llround(partials[i].azimuth / m_angularError);
+            key[1] = std::llround(partials[i].elevation / m_angularError);
+        }
+        else
         {
-            m_ifftSpectrumArray[i][j] = kfr::complex(m_spectrumArray[i][j].real(), m_spectrumArray[i][j].imag()); 
+            // Bit patterns, so only identical directions share a bucket
+            std::int32_t azimuth;
+            std::int32_t elevation;
+            std::memcpy(&azimuth, &partials[i].azimuth, sizeof(float));
+            std::memcpy(&elevation, &partials[i].elevation, sizeof(float));
+            key[0] = azimuth;
+            key[1] = elevation;
         }
 
-        m_plan.execute(m_ifftSamplesArray[i], m_ifftSpectrumArray[i], m_temp);
+        int b = 0;
+
+        while (b < buckets && m_bucketKeys[b] != key)
+            ++b;
+
+        if (b == buckets)
+        {
+            // More buckets than channels never pays off
+            if (buckets == m_channels - 1)
+                return 0;
+
+            m_bucketKeys[b] = key;
+            m_bucketEncoding[b].fill(0.0);
+            m_bucketWeights[b] = 0.0;
+            ++buckets;
+        }
+
+        m_partialBuckets[i] = b;
+
+        // W carries the distance gain, the encoding only the direction
+        const T amplitude = partials[i].amplitude;
+        const T normalisation = amplitude / partials[i].bFormat[0];
+
+        for (int c = 0; c < m_channels; ++c)
+            m_bucketEncoding[b][c] += normalisation * partials[i].bFormat[c];
+
+        m_bucketWeights[b] += amplitude;
+    }
+
+    if (buckets == 0)
+        return 0;
+
+    // Per bucket transforms and time domain encoding against the splat into every channel
+    const long long bins = 2 * m_K + 1;
+    const long long fftCost = static_cast<long long>(FFT_COST_FACTOR) * m_halfFrameSize * static_cast<long long>(std::log2(m_frameSize));
+    const long long channelCost = m_channels * fftCost + partialCount * bins * m_channels;
+    const long long bucketCost = buckets * fftCost + partialCount * bins + 2LL * buckets * m_channels * m_readSamples;
+
+    if (buckets > 1 && bucketCost >= channelCost)
+        return 0;
+
+    for (int b = 0; b < buckets; ++b)
+    {
+        const T weight = m_bucketWeights[b] > 0 ? static_cast<T>(1.0) / m_bucketWeights[b] : static_cast<T>(0.0);
+
+        for (int c = 0; c < m_channels; ++c)
+            m_bucketEncoding[b][c] *= weight;
+    }
+
+    return buckets;
+}
+
+template <typename T>
+void IFFT<T>::createSpectrumBuckets(const std::vector<Partial<float>>& partials) noexcept
+{
+    const int partialCount = static_cast<int>(partials.size());
+
+    for (int b = 0; b < m_bucketCount; ++b)
+        std::fill(m_spectrumRows[b], m_spectrumRows[b] + m_halfFrameSize + 1, std::complex<T>(0.0, 0.0));
+
+    advancePhases(partials, 0, partialCount);
+    m_cacheHits = refreshCoefficients(partials, 0, partialCount);
+
+    for (int i = 0; i < partialCount; ++i)
+    {
+        if (m_partialBuckets[i] < 0)
+            continue;
+
+        createMotifRow(i);
+
+        if (m_rowWidths[i] == 0)
+            continue;
+
+        SpectralSplat<T>::accumulate(reinterpret_cast<T*>(m_spectrumRows[m_partialBuckets[i]] + m_rowFirstBins[i]), 
+                                     reinterpret_cast<const T*>(m_rows.data() + i * m_rowStride), 
+                                     partials[i].bFormat[0], 2 * m_rowWidths[i]);
+    }
+
+    for (int b = 0; b < m_bucketCount; ++b)
+        foldGuardBins(m_spectrumRows[b], 1);
+}
+
+template <typename T>
+void IFFT<T>::transformBucket(int bucket, int worker) noexcept
+{
+    m_plan.execute(m_bucketFrames[bucket].data(), m_ifftSpectrumArray[bucket].data() + m_guardBins, m_temps[worker].data());
+}
+
+template <typename T>
+void IFFT<T>::encodeBuckets(int channel) noexcept
+{
+    // Only the two ends the overlap-add reads are encoded
+    T* frame = m_ifftSamplesArray[m_currentFrame][channel].data();
+    const int ranges[2] = { 0, m_frameSize - m_readSamples };
+
+    for (int range: ranges)
+    {
+        T* destination = frame + range;
+        const T* source = m_bucketFrames[0].data() + range;
+        const T gain = m_bucketEncoding[0][channel];
+
+        for (int k = 0; k < m_readSamples; ++k)
+            destination[k] = gain * source[k];
+
+        for (int b = 1; b < m_bucketCount; ++b)
+            SpectralSplat<T>::accumulateScalar(destination, m_bucketFrames[b].data() + range, m_bucketEncoding[b][channel], m_readSamples);
+    }
+}
+
+template <typename T>
+void IFFT<T>::transformBucketTask(void* context, int bucket, int worker) noexcept
+{
+    static_cast<IFFT<T>*>(context)->transformBucket(bucket, worker);
+}
+
+template <typename T>
+void IFFT<T>::transformPair(int pair, int worker) noexcept
+{
+    // Z = X + iY over the full Hermitian extension, z = x + iy. DC and Nyquist are real for the real plan
+    const int first = 2 * pair;
+    const int second = first + 1;
+    const std::complex<T>* spectra[2];
+    int stride = 1;
+
+    if (m_layout == SpectrumLayout::Interleaved)
+    {
+        spectra[0] = getInterleavedChannel(first);
+        spectra[1] = getInterleavedChannel(second);
+        stride = m_blockChannels;
+    }
+    else
+    {
+        spectra[0] = m_spectrumRows[first];
+        spectra[1] = m_spectrumRows[second];
+    }
+
+    kfr::univector<kfr::complex<T>>& packed = m_pairBuffers[worker][0];
+    kfr::univector<kfr::complex<T>>& frames = m_pairBuffers[worker][1];
+
+    packed[0] = kfr::complex<T>(spectra[0][0].real(), spectra[1][0].real());
+    packed[m_halfFrameSize] = kfr::complex<T>(spectra[0][m_halfFrameSize * stride].real(), spectra[1][m_halfFrameSize * stride].real());
+
+    for (int k = 1; k < m_halfFrameSize; ++k)
+    {
+        const std::complex<T> x = spectra[0][k * stride];
+        const std::complex<T> y = spectra[1][k * stride];
+
+        packed[k] = kfr::complex<T>(x.real() - y.imag(), x.imag() + y.real());
+        packed[m_frameSize - k] = kfr::complex<T>(x.real() + y.imag(), y.real() - x.imag());
+    }
+
+    m_pairPlan.execute(frames, packed, m_temps[worker], true);
+
+    // Only the two ends the overlap-add reads are separated
+    T* frameFirst = m_ifftSamplesArray[m_currentFrame][first].data();
+    T* frameSecond = m_ifftSamplesArray[m_currentFrame][second].data();
+    const int ranges[2] = { 0, m_frameSize - m_readSamples };
+
+    for (int range: ranges)
+    {
+        for (int k = range; k < range + m_readSamples; ++k)
+        {
+            frameFirst[k] = frames[k].real();
+            frameSecond[k] = frames[k].imag();
+        }
+    }
+}
+
+template <typename T>
+void IFFT<T>::transformBatch() noexcept
+{
+    std::array<const std::complex<T>*, AC> spectra;
+    std::array<T*, AC> frames;
+    int stride = 1;
+
+    for (int c = 0; c < m_channels; ++c)
+    {
+        if (m_layout == SpectrumLayout::Interleaved)
+        {
+            spectra[c] = getInterleavedChannel(c);
+            stride = m_blockChannels;
+        }
+        else
+        {
+            spectra[c] = m_spectrumRows[c];
+        }
+
+        frames[c] = m_ifftSamplesArray[m_currentFrame][c].data();
+    }
+
+    m_batchedIFFT->execute(spectra.data(), stride, m_channels);
+
+    // The batch is pruned to the two ends the overlap-add reads, only they are copied out
+    m_batchedIFFT->getSamples(frames.data(), 0, m_readSamples, m_channels);
+    m_batchedIFFT->getSamples(frames.data(), m_frameSize - m_readSamples, m_readSamples, m_channels);
+}
+
+template <typename T>
+void IFFT<T>::setBatchedTransform(bool batched)
+{
+    if (!batched)
+        m_batchedIFFT.reset();
+    else if (!m_batchedIFFT)
+    {
+        m_batchedIFFT = std::make_unique<BatchedIFFT<T>>(m_frameSize, AC);
+        m_batchedIFFT->setOutputs(m_readSamples);
+    }
+}
+
+template <typename T>
+bool IFFT<T>::setAdaptiveHop(bool adaptive)
+{
+    m_adaptiveHop = adaptive && m_longHop > m_shortHop;
+    m_readSamples = m_adaptiveHop ? m_longHop : m_shortHop;
+    m_scenePartials = -1;
+
+    if (m_adaptiveHop)
+        m_scene.resize(m_partialCapacity * (2 + AC), 0.0f);
+
+    for (auto& channel: bufferArray)
+        channel.resize(m_readSamples);
+
+    if (m_batchedIFFT)
+        m_batchedIFFT->setOutputs(m_readSamples);
+
+    return m_adaptiveHop == adaptive;
+}
+
+template <typename T>
+bool IFFT<T>::isStationary(const std::vector<Partial<float>>& partials) noexcept
+{
+    const int partialCount = static_cast<int>(partials.size());
+    const int stride = 2 + AC;
+    bool stationary = partialCount == m_scenePartials;
+
+    for (int i = 0; i < partialCount; ++i)
+    {
+        const Partial<float>& partial = partials[i];
+        float* scene = m_scene.data() + i * stride;
+
+        stationary = stationary && scene[0] == partial.amplitude && scene[1] == partial.frequency
+                     && std::equal(partial.bFormat.begin(), partial.bFormat.end(), scene + 2);
+
+        scene[0] = partial.amplitude;
+        scene[1] = partial.frequency;
+        std::copy(partial.bFormat.begin(), partial.bFormat.end(), scene + 2);
+    }
+
+    m_scenePartials = partialCount;
+
+    return stationary;
+}
+
+template <typename T>
+void IFFT<T>::transformPairTask(void* context, int pair, int worker) noexcept
+{
+    static_cast<IFFT<T>*>(context)->transformPair(pair, worker);
+}
+
+template <typename T>
+void IFFT<T>::setDirectionBucketing(bool enabled, T angularError)
+{
+    m_directionBucketing = enabled;
+    m_angularError = std::max(angularError, static_cast<T>(0.0));
+    m_bucketCount = 0;
+
+    if (enabled)
+    {
+        for (auto& frame: m_bucketFrames)
+            frame.resize(m_frameSize, 0.0);
+    }
+}
+
+template <typename T>
+void IFFT<T>::IFFTprocess() noexcept
+{
+    if (m_bucketCount > 0)
+    {
+        if (m_workerPool)
+        {
+            m_workerPool->run(&IFFT<T>::transformBucketTask, this, m_bucketCount);
+        }
+        else
+        {
+            for (int b = 0; b < m_bucketCount; ++b)
+                transformBucket(b, 0);
+        }
+    }
+    else if (m_sparseHop)
+    {
+        synthesizeSparse();
+    }
+
+    m_batchedHop = m_batchedIFFT && m_bucketCount == 0 && !m_sparseHop;
+
+    if (m_batchedHop)
+        transformBatch();
+
+    m_pairCount = (m_channelPairing && m_bucketCount == 0 && !m_sparseHop && !m_batchedHop) ? m_channels / 2 : 0;
+
+    if (m_pairCount > 0)
+    {
+        if (m_workerPool)
+        {
+            m_workerPool->run(&IFFT<T>::transformPairTask, this, m_pairCount);
+        }
+        else
+        {
+            for (int p = 0; p < m_pairCount; ++p)
+                transformPair(p, 0);
+        }
+    }
+
+    if (m_workerPool)
+    {
+        m_workerPool->run(&IFFT<T>::processChannelTask, this, m_channels);
+    }
+    else
+    {
+        for (int i = 0; i < m_channels; ++i)
+            processChannel(i, 0);
+    }
+
+    // The frame just rendered holds the overlap of the next hop
+    m_currentFrame = 1 - m_currentFrame;
+}
+
+template <typename T>
+void IFFT<T>::IFFTprocess(float* const* outputs, const float* gain, int numSamples) noexcept
+{
+    m_outputs = outputs;
+    m_outputGain = gain;
+    m_outputSamples = std::min(numSamples, m_hopSize);
+
+    IFFTprocess();
+
+    m_outputs = nullptr;
+    m_outputGain = nullptr;
+}
+
+template <typename T>
+void IFFT<T>::processChannel(int i, int worker) noexcept
+{
+    if (m_bucketCount > 0)
+    {
+        encodeBuckets(i);
+    }
+    else if (!m_sparseHop && !m_batchedHop && i >= 2 * m_pairCount)
+    {
+        if (m_layout == SpectrumLayout::Interleaved)
+        {
+            // Deinterleave the channel out of its block
+            const std::complex<T>* source = getInterleavedChannel(i);
+
+            for (int j = 0; j < m_halfFrameSize + 1; ++j)
+                m_spectrumRows[i][j] = source[j * m_blockChannels];
+        }
+
+        m_plan.execute(m_ifftSamplesArray[m_currentFrame][i].data(), m_ifftSpectrumArray[i].data() + m_guardBins, m_temps[worker].data());
+    }
+
+    // Overlap-add straight from the current and the previous frame, no overlap buffer is kept. The
+    // previous frame's tail falls over the current hop, as the current frame's head rises
+    const T* current = m_ifftSamplesArray[m_currentFrame][i].data() + m_frameSize - m_hopSize;
+    const T* previous = m_ifftSamplesArray[1 - m_currentFrame][i].data();
+    const T* head = m_hopSize == m_shortHop ? m_synthWindowHead.data() : m_longWindowHead.data();
+    const T* tail = m_hopSize == m_shortHop ? m_synthWindowTail.data() : m_longWindowTail.data();
+
+    if (m_outputs)
+    {
+        float* output = m_outputs[i];
+        const float* gain = m_outputGain;
+
+        if (gain)
+        {
+            for (int k = 0; k < m_outputSamples; ++k)
+                output[k] = static_cast<float>((current[k] * head[k] + previous[k] * tail[k]) * gain[k]);
+        }
+        else
+        {
+            for (int k = 0; k < m_outputSamples; ++k)
+                output[k] = static_cast<float>(current[k] * head[k] + previous[k] * tail[k]);
+        }
+    }
+    else
+    {
+        T* output = bufferArray[i].data();
 
         for (int k = 0; k < m_hopSize; ++k)
+            output[k] = current[k] * head[k] + previous[k] * tail[k];
+    }
+}
+
+template <typename T>
+void IFFT<T>::processChannelTask(void* context, int channel, int worker) noexcept
+{
+    static_cast<IFFT<T>*>(context)->processChannel(channel, worker);
+}
+
+template <typename T>
+void IFFT<T>::setWorkerThreads(int threads)
+{
+    threads = std::max(1, std::min(threads, AC));
+
+    m_workerPool.reset();
+    m_temps.resize(threads, kfr::univector<kfr::u8>(std::max(m_plan.temp_size, m_pairPlan.temp_size)));
+    m_pairBuffers.resize(threads);
+
+    for (auto& buffers: m_pairBuffers)
+    {
+        buffers[0].resize(m_frameSize, kfr::complex<T>(0.0, 0.0));
+        buffers[1].resize(m_frameSize, kfr::complex<T>(0.0, 0.0));
+    }
+    m_splatPartitions.clear();
+
+    if (threads > 1)
+    {
+        m_workerPool = std::make_unique<WorkerPool>(threads);
+        m_splatPartitions.resize(MAX_SPLAT_PARTITIONS);
+
+        for (int p = 0; p < MAX_SPLAT_PARTITIONS; ++p)
         {
-            bufferArray[i][k] = m_ifftSamplesArray[i][m_halfFrameSize + m_hopSize + k] * m_synthWindow[m_hopSize + k] / m_frameSize + m_overlapBufferArray[i][k];
-            //bufferArray[i][k] = m_ifftSamplesArray[i][k] * m_synthWindow[m_halfFrameSize + k] / m_frameSize + m_overlapBufferArray[i][k];
-            m_overlapBufferArray[i][k] = m_ifftSamplesArray[i][k] * m_synthWindow[m_halfFrameSize + k] / m_frameSize;
+            auto& partition = m_splatPartitions[p];
+            partition.motifCoefficients.resize(2 * m_K + 1, std::complex<T>(0.0, 0.0));
+            partition.binCounts.resize(m_halfFrameSize + 1, 0);
+            partition.cacheHits = 0;
+
+            for (int c = 0; c < AC; ++c)
+            {
+                if (p > 0)
+                    partition.spectrumArray[c].resize(m_halfFrameSize + 1 + 2 * m_guardBins, std::complex<T>(0.0, 0.0));
+
+                partition.rows[c] = p > 0 ? partition.spectrumArray[c].data() + m_guardBins : m_spectrumRows[c];
+            }
         }
     }
 }
 
-void IFFT::setChannels(int channels) noexcept
+template <typename T>
+void IFFT<T>::setChannels(int channels) noexcept
 {
+   // Rows of channels that were inactive still hold their last spectrum
+   if (channels > m_channels)
+   {
+       m_dirtyLow = 0;
+       m_dirtyHigh = m_halfFrameSize + 1;
+   }
+
    m_channels = channels;
 }
 
-void IFFT::createSynthWindow()
+template <typename T>
+void IFFT<T>::createSynthWindow(int hopSize, std::vector<T>& head, std::vector<T>& tail)
 {
-    int twoTimeshopSize = 2 * m_hopSize;
+    // Triangle of two hops around the frame centre, so exactly two frames overlap at every overlap factor
+    std::vector<T> synthWindow(m_frameSize, 0.0);
+    int twoTimeshopSize = 2 * hopSize;
+    int overlapStart = m_halfFrameSize - hopSize;
 
-    Window<double> inverseMotif(m_WindowType, m_frameSize, false);
+    Window<T> inverseMotif(m_WindowType, m_frameSize, false);
     inverseMotif.normalize();
     auto inverseMotifWindow = inverseMotif.getWindow();
 
-    Window<double> overlap(WindowType::Triangular, twoTimeshopSize, true);
+    Window<T> overlap(WindowType::Triangular, twoTimeshopSize, true);
     auto overlapWindow = overlap.getWindow();
 
-    std::transform(m_synthWindow.begin() + m_hopSize, m_synthWindow.begin() + m_hopSize + twoTimeshopSize,
-                   overlapWindow.begin(), m_synthWindow.begin() + m_hopSize,
-                   std::plus<double>());
+    std::transform(synthWindow.begin() + overlapStart, synthWindow.begin() + overlapStart + twoTimeshopSize,
+                   overlapWindow.begin(), synthWindow.begin() + overlapStart,
+                   std::plus<T>());
 
-    std::transform(m_synthWindow.begin(), m_synthWindow.end(),
-                   inverseMotifWindow.begin(), m_synthWindow.begin(),
-                   std::divides<double>());
-}   
+    // At 2x the triangle spans the whole frame, where windows like Hann reach 0
+    std::transform(synthWindow.begin(), synthWindow.end(),
+                   inverseMotifWindow.begin(), synthWindow.begin(),
+                   [](T overlapValue, T motifValue) { return motifValue > 0 ? overlapValue / motifValue : static_cast<T>(0.0); });
 
-double IFFT::phaseAdjustment(double phase, double frequency) noexcept
-{
-    return std::fmod(phase + 2 * M_PI * frequency * 0.5 * m_hopSize * m_T, 2 * M_PI);
-    //double x =phase + frequency * m_phaseCorrectionFactor;
-    //return x - trunc(x / (2 * M_PI)) * 2 * M_PI; 
-}
+    head.resize(hopSize);
+    tail.resize(hopSize);
+
+    for (int k = 0; k < hopSize; ++k)
+    {
+        head[k] = synthWindow[m_halfFrameSize - hopSize + k] / m_frameSize;
+        tail[k] = synthWindow[m_halfFrameSize + k] / m_frameSize;
+    }
+}   
 
 //void IFFT::resetPhase()
 //{
@@ -258,9 +1386,16 @@ double IFFT::phaseAdjustment(double phase, double frequency) noexcept
 //    m_phases.resize(10000, 0.0);
 //}
 
-void IFFT::setSampleRate(float sampleRate) noexcept
+template <typename T>
+void IFFT<T>::setSampleRate(float sampleRate) noexcept
 {
-    m_T = 1.0 / sampleRate;
+    m_T = static_cast<T>(1.0) / sampleRate;
+
+    // The rotations and the cached bin locations depend on the sample rate
+    std::fill(m_rotationFrequencies.begin(), m_rotationFrequencies.end(), -1.0f);
+    std::fill(m_cachedFrequencies.begin(), m_cachedFrequencies.end(), -1.0f);
+
+    createMaskingBands();
 }
 
 //int IFFT::getTimer() noexcept { return m_sampleCount; }
@@ -271,3 +1406,5 @@ void IFFT::setSampleRate(float sampleRate) noexcept
 
 //int IFFT::getHopSize() noexcept { return m_hopSize; }
 
+template class IFFT<float>;
+template class IFFT<double>;
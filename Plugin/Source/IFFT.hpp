@@ -4,6 +4,32 @@
  *
  * \brief The IFFT synthesis Class ...
  *
+ * The engine is a template over the sample type. IFFT<float> halves the
+ * memory traffic of the splat and the transforms, IFFT<double> is the
+ * reference path. Both are instantiated in IFFT.cpp.
+ *
+ * The inverse transforms and the overlap-add of the channels are
+ * independent and can be spread across a WorkerPool, see setWorkerThreads().
+ * With a pool, large partial lists are also split into partitions that are
+ * splatted into private spectra and summed in a fixed order, so the result
+ * does not depend on the thread count or the scheduling.
+ *
+ * Ambisonic encoding is linear, so partials that share (nearly) one
+ * direction can be summed into one mono spectrum, transformed once and
+ * encoded into the channels in the time domain, see setDirectionBucketing().
+ *
+ * Only the bins the last hop occupied are cleared. When few bins are occupied,
+ * e.g. a single sine, the inverse real DFT of just those bins is evaluated at the
+ * samples the overlap-add reads instead of running the transforms, see setSparseBinLimit().
+ *
+ * The channels are real, so two of them can share one complex inverse transform
+ * of X + iY whose real and imaginary parts are the two frames, see setChannelPairing().
+ * Alternatively all channels are transformed in one batch that is vectorized
+ * across the channels, see setBatchedTransform().
+ *
+ * While a scene holds still, its frames only differ in their phases, so the
+ * hop can double until the partials change again, see setAdaptiveHop().
+ *
  *
  * \author Hilko Tondock
  *
@@ -22,19 +48,50 @@
     #define M_PI 3.14159265358979323846
 #endif
 #include <complex>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <limits>
+#include <memory>
+#include <type_traits>
 
 #include <shared_processing_code/shared_processing_code.h>
 
 #include "SpectralMotif.hpp" 
+#include "SpectralSplat.hpp"
+#include "BatchedIFFT.hpp"
 #include "BasicSignals.hpp"
+#include "WorkerPool.hpp"
 
 const int AC = 16; // Ambisonics Channel Number
 
+const int SPECTRUM_BLOCK_BYTES = 32768; // L1 budget of one interleaved channel block
+const int SPECTRUM_ALIGNMENT_BYTES = 64; // The guard bins keep the transform input at this alignment
+
+const int PARALLEL_SPLAT_CROSSOVER = 2000; // Partials below which the splat stays single-threaded, see Benchmark
+const int SPLAT_PARTITION_SIZE = 1000; // Partials per partition of the parallel splat
+const int MAX_SPLAT_PARTITIONS = 8;
+
+const int PHASOR_RENORMALISATION_HOPS = 64; // Hops between the renormalisations of the partial phasors
+
+const int MASKING_BANDS = 32; // Critical bands of the masking estimate, Bark bands up to 96 kHz sample rate
+
+const int FFT_COST_FACTOR = 2; // Cost of one FFT butterfly relative to one splat multiply-add, see Benchmark
+const int SPARSE_SYNTHESIS_COST_FACTOR = 1; // Cost of one direct synthesis multiply-add relative to one splat multiply-add, see Benchmark
+
+enum class SpectrumLayout
+{
+    ChannelMajor = 0, // One spectrum array per channel
+    Interleaved       // Bin-major, channels interleaved in L1 sized blocks
+};
+
+template <typename T>
 class IFFT
 {
 public:
+    // overlapFactor is 2, 4 or 8 (anything else falls back to 4), the hop is ifftSize / overlapFactor
     IFFT(int ifftSize,
+         int overlapFactor,
          WindowType windowType,
          int oversamplingFactor,
          int K);
@@ -47,11 +104,17 @@ public:
     
     void createSpectrum(const std::vector<Partial<float>>& partials) noexcept;
 
+    // Renders one hop of every active channel into bufferArray
     void IFFTprocess() noexcept;
 
+    // Fused output stage: overlap-add, gain and float conversion written straight into
+    // the host channels. outputs holds one pointer per active channel, gain one value
+    // per sample (nullptr => unity), and at most getHopSize() samples are written.
+    void IFFTprocess(float* const* outputs, const float* gain, int numSamples) noexcept;
+
     void resetPhase() noexcept;
 
-    std::array<std::vector<double>, AC> bufferArray;
+    std::array<std::vector<T>, AC> bufferArray;
     
     int getTimer() noexcept; 
 
@@ -59,12 +122,108 @@ public:
 
     void resetTimer() noexcept;
 
+    // Hop of the last createSpectrum(), see setAdaptiveHop()
     int getHopSize() noexcept;
 
+    // Longest hop IFFTprocess() may render
+    int getMaxHopSize() noexcept;
+
+    int getOverlapFactor() noexcept;
+
+    // Doubles the hop while the amplitudes, frequencies and direction gains of the partials stay
+    // unchanged from hop to hop, and returns to the short hop with the first hop that changes them.
+    // Rejected below an overlap factor of 8, where the long hop spans the frame and the window division
+    // fails: returns false and keeps the fixed hop. Off by default. Allocates, so call it outside the
+    // audio callback
+    bool setAdaptiveHop(bool adaptive);
+
+    bool getAdaptiveHop() noexcept;
+
+    // Fractional lookup in the half motif table, cubic by default
+    void setMotifInterpolation(MotifInterpolation interpolation) noexcept;
+
+    // Share of the last hop's partials whose amplitude and frequency were unchanged,
+    // so their bin location and scaled motif came from the coefficient cache
+    float getCoefficientCacheHitRate() noexcept;
+
+    // Amplitude driven motif width: every partial keeps the fewest bins whose truncation error stays
+    // decibels below the RMS level of the hop's partials, so the error summed over all partials stays
+    // decibels below the signal. 0 or above splats every partial with all 2K + 1 bins (default)
+    void setMotifNoiseFloor(T decibels) noexcept;
+
+    // Mean motif bins per partial of the last hop, culled partials count as 0
+    float getMotifBinsPerPartial() noexcept;
+
+    // Partials whose level at the W channel (amplitude times 1 / distance) is below decibels
+    // re full scale are culled: they are not splatted, but their phases keep running. -infinity => off (default)
+    void setCullingThreshold(T decibels) noexcept;
+
+    // Partials more than -decibels below the loudest partial of their critical band are culled,
+    // a simple masking estimate. 0 or above disables it (default)
+    void setMaskingThreshold(T decibels) noexcept;
+
+    // Partials culled in the last hop
+    int getCulledPartials() noexcept;
+
+    // Enabled by default when the splat kernel is compiled for AVX2 or AVX-512
+    void setVectorizedSplat(bool vectorized) noexcept;
+
+    // Splats the partials in the order of their bins instead of the input order, so consecutive
+    // partials write to bins that are already cached. Counting sort, enabled by default
+    void setBinSortedSplat(bool sorted) noexcept;
+
+    void setSpectrumLayout(SpectrumLayout layout) noexcept;
+
+    SpectrumLayout getSpectrumLayout() noexcept;
+
+    int getBlockChannels() noexcept;
+
+    // Threads for IFFTprocess including the calling thread, 1 runs it serially.
+    // Spawns the workers, so call it outside the audio callback (e.g. in prepareToPlay)
+    void setWorkerThreads(int threads);
+
+    int getWorkerThreads() noexcept;
+
+    // Sizes the per partial state (phases, motif rows, buckets). createSpectrum grows it on demand,
+    // so call it outside the audio callback with the largest partial count to avoid allocating there
+    void setMaxPartials(int partials);
+
+    // Partial count from which createSpectrum splits the partials across the worker pool
+    void setParallelSplatThreshold(int partials) noexcept;
+
+    // Quantizes partial directions to a grid of angularError radians (0 => only identical
+    // directions are merged) and renders one IFFT per direction bucket whenever that is
+    // cheaper than splatting into every channel. Allocates, so call it outside the audio callback.
+    void setDirectionBucketing(bool enabled, T angularError);
+
+    // Buckets of the last hop, 0 if it was rendered with the channel splat
+    int getDirectionBuckets() noexcept;
+
+    // Occupied bins below which a channel-major hop is synthesised directly instead of transformed,
+    // set from the FFT_COST_FACTOR/SPARSE_SYNTHESIS_COST_FACTOR cost model. 0 always transforms
+    void setSparseBinLimit(int bins) noexcept;
+
+    int getSparseBinLimit() noexcept;
+
+    // Occupied bins of the last hop, 0 if it was transformed
+    int getSparseBins() noexcept;
+
+    // Transforms two channels with one complex IFFT instead of two real ones, off by default, see Benchmark
+    void setChannelPairing(bool paired) noexcept;
+
+    bool getChannelPairing() noexcept;
+
+    // Transforms all active channels in one batch vectorized across the channels instead of one KFR
+    // call per channel, output-pruned to the samples the overlap-add reads. Off by default, the KFR
+    // plans are not pruned, see Benchmark. Allocates, so call it outside the audio callback
+    void setBatchedTransform(bool batched);
+
+    bool getBatchedTransform() noexcept;
+
 private:
     WindowType m_WindowType;
     
-    double m_T;
+    T m_T;
     
     int m_channels;
     
@@ -72,41 +231,306 @@ private:
     
     int m_halfFrameSize;
     
-    int m_hopSize;
+    int m_overlapFactor;
+    
+    int m_hopSize; // Hop of the current frame
+
+    // Adaptive hop: stationary scenes are rendered with m_longHop instead of m_shortHop, which only
+    // differ at overlap factor 8. Every frame holds m_readSamples samples at either end, so the
+    // overlap-add can read either hop
+    int m_shortHop;
+    int m_longHop;
+    int m_previousHop;
+    int m_readSamples;
+    bool m_adaptiveHop;
+    int m_scenePartials; // Partials of the last hop's scene, -1 => unknown
+    std::vector<float> m_scene; // Amplitude, frequency and AC direction gains of every partial of the last hop
     
     int m_oversamplingFactor;
     
     int m_K;
     
-    SpectralMotif<double> m_motif;
+    SpectralMotif<T> m_motif;
+
+    // Phase engine, one entry per partial as structure of arrays: the phasor half a hop past the
+    // last frame centre, the phasor at the current frame centre and the rotation by half a short hop
+    // for the frequency it was computed for
+    int m_partialCapacity;
+    int m_phasorHops;
+    std::vector<T> m_phasorReal;
+    std::vector<T> m_phasorImag;
+    std::vector<T> m_centreReal;
+    std::vector<T> m_centreImag;
+    std::vector<T> m_rotationReal;
+    std::vector<T> m_rotationImag;
+    std::vector<float> m_rotationFrequencies;
 
-    int m_motifMiddleIndex;
+    // Coefficient cache: bin location and amplitude scaled motif of every partial,
+    // rebuilt only for partials whose amplitude or frequency changed
+    std::vector<float> m_cachedAmplitudes;
+    std::vector<float> m_cachedFrequencies;
+    std::vector<T> m_binLocations;
+    std::vector<int> m_binFrameLocations;
+    std::vector<T> m_scaledMotifs; // 2 * m_K + 1 per partial
+    int m_cacheHits;
+    int m_cachePartials;
 
-    std::vector<double> m_phases;
+    // Partial selection: partial i is splatted with the bins +-m_motifBins[i] around its frame
+    // location, -1 if it is culled. m_motifThresholds[k] is the largest level +-k bins suffice for
+    T m_motifNoiseFloor; // Linear, 0 => every partial keeps +-m_K
+    std::vector<int> m_motifBins;
+    std::vector<T> m_motifThresholds;
+    long long m_motifBinTotal;
+    T m_cullingThreshold; // Linear
+    T m_maskingThreshold; // Linear, 0 => no masking
+    int m_culledPartials;
+    std::vector<int> m_binBands; // Critical band of every bin
+    std::array<T, MASKING_BANDS> m_bandLevels;
     
-    std::array<std::vector<std::complex<double>>, AC> m_spectrumArray;
-    std::vector<double> m_synthWindow;
-    std::array<std::vector<double>, AC> m_overlapBufferArray;
+    // Channel-major spectrum, aliases m_ifftSpectrumArray past its m_guardBins leading bins.
+    // The splat writes up to m_K bins beyond DC and Nyquist into the guard bins
+    std::array<std::complex<T>*, AC> m_spectrumRows;
+    int m_guardBins;
+    std::vector<std::complex<T>> m_motifCoefficients;
+    std::array<T, AC> m_weights;
+    bool m_vectorizedSplat;
+
+    // Splat order: partials sorted by frame bin, so consecutive partials write neighbouring bins
+    bool m_binSortedSplat;
+    std::vector<int> m_splatOrder;
+    std::vector<int> m_binCounts;
+
+    // Interleaved layout: block b holds channels [b * m_blockChannels, (b + 1) * m_blockChannels)
+    // as [bin][channel] with m_guardBins on both sides, so a block fits SPECTRUM_BLOCK_BYTES
+    SpectrumLayout m_layout;
+    int m_blockChannels;
+    int m_blockSize;
+    std::vector<std::complex<T>> m_interleavedSpectrum;
+    std::array<T, 2 * AC> m_interleavedWeights;
+
+    // Motif row of every partial, built once per hop and splatted block by block
+    int m_rowStride;
+    std::vector<int> m_rowFirstBins;
+    std::vector<int> m_rowWidths;
+    std::vector<std::complex<T>> m_rows;
+    std::vector<T> m_synthWindowHead;
+    std::vector<T> m_synthWindowTail;
+    std::vector<T> m_longWindowHead;
+    std::vector<T> m_longWindowTail;
+
+    // Sparse spectrum: [m_dirtyLow, m_dirtyHigh) holds every bin of the channel-major input that
+    // may be non-zero. Hops with fewer than m_sparseBinLimit occupied bins skip the transforms,
+    // their coefficients are gathered as [bin][channel] for the direct synthesis
+    int m_dirtyLow;
+    int m_dirtyHigh;
+    int m_sparseBinLimit;
+    bool m_sparseHop;
+    int m_sparseBinCount;
+    std::vector<unsigned char> m_binOccupied;
+    std::vector<int> m_sparseBins;
+    std::vector<int> m_sparseIndices;
+    std::vector<T> m_sparseReal;
+    std::vector<T> m_sparseImag;
+    std::vector<T> m_sparseCos; // cos/sin of 2 pi n / N
+    std::vector<T> m_sparseSin;
 
     int m_sampleCount;
    
     ///////////////// KFR ///////////////////////////////
-    kfr::dft_plan_real<double> m_plan;
-    kfr::univector<kfr::u8> m_temp;
-    std::array<kfr::univector<kfr::complex<double>>, AC> m_ifftSpectrumArray;
-    std::array<kfr::univector<double>, AC> m_ifftSamplesArray;
+    kfr::dft_plan_real<T> m_plan;
+    kfr::dft_plan<T> m_pairPlan; // Complex plan of the channel pairs
+    std::vector<kfr::univector<kfr::u8>> m_temps; // One per worker thread
+    std::vector<std::array<kfr::univector<kfr::complex<T>>, 2>> m_pairBuffers; // Packed spectrum and output, one per worker thread
+    std::array<kfr::univector<kfr::complex<T>>, AC> m_ifftSpectrumArray;
+    std::array<std::array<kfr::univector<T>, AC>, 2> m_ifftSamplesArray; // Current and previous frame
     /////////////////////////////////////////////////////
+
+    std::unique_ptr<WorkerPool> m_workerPool;
+
+    bool m_channelPairing;
+    int m_pairCount; // Pairs of the last IFFTprocess, channels [0, 2 * m_pairCount) are transformed by them
+
+    std::unique_ptr<BatchedIFFT<T>> m_batchedIFFT; // Only allocated while the batched transform is enabled
+    bool m_batchedHop;
+
+    // Direction buckets: mono spectra in the first m_bucketCount KFR inputs,
+    // encoding = amplitude weighted mean of the members' W normalized B-format vectors
+    bool m_directionBucketing;
+    T m_angularError;
+    int m_bucketCount;
+    std::vector<int> m_partialBuckets;
+    std::array<std::array<long long, 2>, AC> m_bucketKeys;
+    std::array<std::array<T, AC>, AC> m_bucketEncoding;
+    std::array<T, AC> m_bucketWeights;
+    std::array<kfr::univector<T>, AC> m_bucketFrames;
+
+    int m_currentFrame;
+    float* const* m_outputs;
+    const float* m_outputGain;
+    int m_outputSamples;
+
+    // Partition 0 splats straight into the IFFT input, the others into private spectra
+    struct SplatPartition
+    {
+        std::array<std::vector<std::complex<T>>, AC> spectrumArray;
+        std::array<std::complex<T>*, AC> rows;
+        std::vector<std::complex<T>> motifCoefficients;
+        int cacheHits;
+        std::array<T, AC> weights;
+        std::vector<int> binCounts;
+    };
+
+    std::vector<SplatPartition> m_splatPartitions;
+    const std::vector<Partial<float>>* m_splatInput;
+    int m_splatPartitionCount;
+    int m_parallelSplatThreshold;
     
-    void createSynthWindow();
+    // Head and tail of the synthesis window of a hop, pre-scaled by 1/N of the inverse transform
+    void createSynthWindow(int hopSize, std::vector<T>& head, std::vector<T>& tail);
+
+    // Compares the partials with the last hop's scene and stores them as the new scene
+    bool isStationary(const std::vector<Partial<float>>& partials) noexcept;
+
+    void advancePhases(const std::vector<Partial<float>>& partials, int begin, int end) noexcept;
+
+    void createSpectrumInterleaved(const std::vector<Partial<float>>& partials) noexcept;
+
+    // Bin 0 of the channel in its interleaved block, consecutive bins are m_blockChannels apart
+    std::complex<T>* getInterleavedChannel(int channel) noexcept;
+
+    void createMotifRow(int index) noexcept;
+
+    // Returns the coefficient cache hits of the range
+    int splatPartials(const std::vector<Partial<float>>& partials,
+                      int begin,
+                      int end,
+                      std::complex<T>* const* rows,
+                      std::complex<T>* coefficients,
+                      T* weightBuffer,
+                      int* binCounts) noexcept;
+
+    // Writes the partials of [begin, end) the splat renders to m_splatOrder from begin on,
+    // sorted by frame bin when m_binSortedSplat. binCounts holds m_halfFrameSize + 1 entries.
+    // Returns their count
+    int orderPartials(int begin, int end, int* binCounts) noexcept;
+
+    int refreshCoefficients(const std::vector<Partial<float>>& partials, int begin, int end) noexcept;
+
+    // Culls the partials and assigns the motif bins of the others, returns the motif bins of all partials
+    long long selectPartials(const std::vector<Partial<float>>& partials) noexcept;
+
+    bool isSelectingPartials() noexcept;
+
+    void resetPartialSelection() noexcept;
+
+    void createMaskingBands() noexcept;
+
+    // Folds the guard bins of a row into the spectrum and clears them, bins are stride apart
+    void foldGuardBins(std::complex<T>* row, int stride) noexcept;
+
+    void updateOccupancy(int partialCount) noexcept;
+
+    void synthesizeSparse() noexcept;
+
+    void createSpectrumParallel(const std::vector<Partial<float>>& partials, int partitions) noexcept;
+
+    int getSplatPartitions(int partialCount) noexcept;
+
+    void splatPartition(int partition) noexcept;
+
+    void reduceChannel(int channel) noexcept;
+
+    static void splatPartitionTask(void* context, int partition, int worker) noexcept;
+
+    static void reduceChannelTask(void* context, int channel, int worker) noexcept;
+
+    int assignDirectionBuckets(const std::vector<Partial<float>>& partials) noexcept;
+
+    void createSpectrumBuckets(const std::vector<Partial<float>>& partials) noexcept;
 
-    double phaseAdjustment (double phase, double frequency) noexcept;
+    void transformBucket(int bucket, int worker) noexcept;
+
+    void encodeBuckets(int channel) noexcept;
+
+    static void transformBucketTask(void* context, int bucket, int worker) noexcept;
+
+    void transformPair(int pair, int worker) noexcept;
+
+    void transformBatch() noexcept;
+
+    static void transformPairTask(void* context, int pair, int worker) noexcept;
+
+    void processChannel(int channel, int worker) noexcept;
+
+    static void processChannelTask(void* context, int channel, int worker) noexcept;
              
 };
  
-inline int IFFT::getTimer() noexcept { return m_sampleCount; }
+template <typename T>
+inline int IFFT<T>::getTimer() noexcept { return m_sampleCount; }
+
+template <typename T>
+inline void IFFT<T>::setTimer(int time) noexcept { m_sampleCount = time; }
+
+template <typename T>
+inline void IFFT<T>::resetTimer() noexcept { m_sampleCount = 0; }
+
+template <typename T>
+inline int IFFT<T>::getHopSize() noexcept { return m_hopSize; }
+
+template <typename T>
+inline int IFFT<T>::getMaxHopSize() noexcept { return m_readSamples; }
+
+template <typename T>
+inline bool IFFT<T>::getAdaptiveHop() noexcept { return m_adaptiveHop; }
+
+template <typename T>
+inline int IFFT<T>::getOverlapFactor() noexcept { return m_overlapFactor; }
+
+template <typename T>
+inline void IFFT<T>::setVectorizedSplat(bool vectorized) noexcept { m_vectorizedSplat = vectorized; }
+
+template <typename T>
+inline void IFFT<T>::setBinSortedSplat(bool sorted) noexcept { m_binSortedSplat = sorted; }
+
+template <typename T>
+inline void IFFT<T>::setSpectrumLayout(SpectrumLayout layout) noexcept { m_layout = layout; }
+
+template <typename T>
+inline SpectrumLayout IFFT<T>::getSpectrumLayout() noexcept { return m_layout; }
+
+template <typename T>
+inline int IFFT<T>::getBlockChannels() noexcept { return m_blockChannels; }
+
+template <typename T>
+inline int IFFT<T>::getWorkerThreads() noexcept { return static_cast<int>(m_temps.size()); }
+
+template <typename T>
+inline void IFFT<T>::setParallelSplatThreshold(int partials) noexcept { m_parallelSplatThreshold = partials; }
+
+template <typename T>
+inline int IFFT<T>::getDirectionBuckets() noexcept { return m_bucketCount; }
+
+template <typename T>
+inline void IFFT<T>::setSparseBinLimit(int bins) noexcept { m_sparseBinLimit = std::max(0, bins); }
+
+template <typename T>
+inline int IFFT<T>::getSparseBinLimit() noexcept { return m_sparseBinLimit; }
+
+template <typename T>
+inline int IFFT<T>::getSparseBins() noexcept { return m_sparseHop ? m_sparseBinCount : 0; }
+
+template <typename T>
+inline int IFFT<T>::getCulledPartials() noexcept { return m_culledPartials; }
+
+template <typename T>
+inline bool IFFT<T>::isSelectingPartials() noexcept { return m_motifNoiseFloor > 0 || m_cullingThreshold > 0 || m_maskingThreshold > 0; }
 
-inline void IFFT::setTimer(int time) noexcept { m_sampleCount = time; }
+template <typename T>
+inline void IFFT<T>::setChannelPairing(bool paired) noexcept { m_channelPairing = paired; }
 
-inline void IFFT::resetTimer() noexcept { m_sampleCount = 0; }
+template <typename T>
+inline bool IFFT<T>::getChannelPairing() noexcept { return m_channelPairing; }
 
-inline int IFFT::getHopSize() noexcept { return m_hopSize; }
\ No newline at end of file
+template <typename T>
+inline bool IFFT<T>::getBatchedTransform() noexcept { return m_batchedIFFT != nullptr; }
\ No newline at end of file
@@ -274,15 +274,9 @@ void PluginAudioProcessorEditor::updateGUI()
     juce::String bufferSizeString = "Buffer Size: ";
     int bufferSize = processor.getBlockSize();
 
-    if (ceil(log2(bufferSize)) == floor(log2(bufferSize)))
-    {
-        bufferSizeString += bufferSize;
-    } 
-    else
-    {
-        bufferSizeString += bufferSize;
-        bufferSizeString += ", but should be power of 2!";
-    }
+    bufferSizeString += bufferSize;
+    bufferSizeString += ", Hop Size: ";
+    bufferSizeString += HOPSIZE;
 
     juce::String sampleRateString = "Sample Rate: ";
     sampleRateString += static_cast<int>(processor.getSampleRate());
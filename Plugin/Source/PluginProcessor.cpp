@@ -6,8 +6,15 @@ PluginAudioProcessor::PluginAudioProcessor()
           Thread ("Background Thread"),
           parameters(*this, nullptr, juce::Identifier("PARAMETERS"), createParameters()),
           signal(SignalType::sine, 0.5, 440.0, 440.0, 0.0),
+          singlePrecision(SINGLEPRECISION),
           gainEnvelope(),
-          gateCount(0)
+          hopLength(HOPSIZE),
+          hopReadPosition(0),
+          activeEngine(FREQDOMAIN ? Engine::Spectral : Engine::TimeDomain),
+          crossfadePosition(ENGINECROSSFADE),
+          gateCount(0),
+          noteOnFromSilence(false),
+          culledPartials(0)
 {
     waveformParameter = parameters.getRawParameterValue("waveform");
     noiseDensityParameter = parameters.getRawParameterValue("noiseDensity");    
@@ -51,31 +58,76 @@ void PluginAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     horizontalDispersion.reset(sampleRate, 0.01);
     verticalDispersion.reset(sampleRate, 0.01);
 
-    ifft = new IFFT(4 * samplesPerBlock, WindowType::BlackmanHarris4term, 128, 7);
-     
-    ifft->setSampleRate(sampleRate);
-    ifft->setTimer(ifft->getHopSize());
+    singlePrecision = SINGLEPRECISION;
+
+    if (singlePrecision)
+    {
+        ifftDouble.reset();
+        ifftFloat = std::make_unique<IFFT<float>>(FRAMESIZE, OVERLAPFACTOR, WindowType::BlackmanHarris4term, 16, 7);
+        configureIFFT(*ifftFloat, sampleRate);
+    }
+    else
+    {
+        ifftFloat.reset();
+        ifftDouble = std::make_unique<IFFT<double>>(FRAMESIZE, OVERLAPFACTOR, WindowType::BlackmanHarris4term, 16, 7);
+        configureIFFT(*ifftDouble, sampleRate);
+    }
 
     gainEnvelope.setAttackRate(0.1 * sampleRate);
     gainEnvelope.setDecayRate(0.5 * sampleRate);
     gainEnvelope.setSustainLevel(0.8);
     gainEnvelope.setReleaseRate(1.5 * sampleRate);
-    gainEnvelopeBuffer.resize(2 * samplesPerBlock, 0.0);
+    gainEnvelopeBuffer.resize(2 * samplesPerBlock, 0.0f);
+    discardBuffer.resize(AC * MAXHOPSIZE, 0.0f);
+
+    for (int channel = 0; channel < AC; ++channel)
+    {
+        hopBuffer[channel].assign(MAXHOPSIZE, 0.0f);
+        hopChannels[channel] = hopBuffer[channel].data();
+    }
+
+    hopLength = HOPSIZE;
+    hopReadPosition = HOPSIZE;
+
+    // Hops are rendered just in time on a fixed grid, so the FIFO does not delay the output, it
+    // quantizes note and parameter changes to hop boundaries. A note-on reaches the spectrum at the
+    // next hop and fades in over the overlap, SNR_Onset measures half the amplitude after HOPSIZE / 2
+    // to 3 * HOPSIZE / 2 samples. Their mean is reported whenever the IFFT may render an onset: the
+    // handover only covers notes from silence, a note-on during a release or a legato note stays on
+    // the IFFT. With the adaptive hop a note-on waits for the rest of a long hop
+    const bool spectralOnsets = FREQDOMAIN || (HYBRIDENGINE && !BENCHMARKING);
+    setLatencySamples(spectralOnsets ? (MAXHOPSIZE + HOPSIZE) / 2 : 0);
     
     int outputChannels = getMainBusNumOutputChannels();
+    int ifftChannels;
 
     if (outputChannels >= 16)
-        ifft->setChannels(16);
+        ifftChannels = 16;
     else if (outputChannels >= 9)
-        ifft->setChannels(9);
+        ifftChannels = 9;
     else if (outputChannels >= 4)
-        ifft->setChannels(4);
+        ifftChannels = 4;
+    else
+        ifftChannels = 1;
+
+    if (singlePrecision)
+        ifftFloat->setChannels(ifftChannels);
     else
-        ifft->setChannels(1);
+        ifftDouble->setChannels(ifftChannels);
          
     triggerAsyncUpdate();
         
-    timeDomain = new TimeDomain(samplesPerBlock, static_cast<float>(sampleRate));
+    timeDomain = std::make_unique<TimeDomain>(samplesPerBlock, static_cast<float>(sampleRate));
+
+    // Both engines are prepared, the selector starts from the FREQDOMAIN engine
+    activeEngine = FREQDOMAIN ? Engine::Spectral : Engine::TimeDomain;
+    engineSelector = std::make_unique<EngineSelector>(FRAMESIZE, HOPSIZE, 7);
+    engineSelector->setEngine(activeEngine);
+    crossfadePosition = ENGINECROSSFADE;
+    crossfadeCurve.resize(ENGINECROSSFADE + 1);
+
+    for (int i = 0; i <= ENGINECROSSFADE; ++i)
+        crossfadeCurve[i] = static_cast<float>(std::sin(0.5 * M_PI * i / ENGINECROSSFADE));
 
     if (BENCHMARKING)
     {
@@ -83,6 +135,23 @@ void PluginAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
     }
 }
 
+template <typename T>
+void PluginAudioProcessor::configureIFFT(IFFT<T>& ifft, double sampleRate)
+{
+    ifft.setSampleRate(sampleRate);
+    ifft.setTimer(ifft.getHopSize());
+    ifft.setWorkerThreads(WORKERTHREADS);
+    ifft.setMaxPartials(std::max(MAXPARTIALS, PARTIALS));
+    ifft.setDirectionBucketing(DIRECTIONBUCKETING, DIRECTIONERROR * M_PI / 180.0);
+    ifft.setMotifNoiseFloor(MOTIFNOISEFLOOR);
+    ifft.setCullingThreshold(CULLINGTHRESHOLD);
+    ifft.setMaskingThreshold(MASKINGTHRESHOLD);
+
+    const bool adaptiveHop = ifft.setAdaptiveHop(ADAPTIVEHOP);
+    jassert(adaptiveHop);
+    juce::ignoreUnused(adaptiveHop);
+}
+
 void PluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     float sampleRate = getSampleRate();
@@ -91,28 +160,29 @@ void PluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     int channelsHost = getMainBusNumOutputChannels();
     int channelsIFFT = channelsHost < channelsGui ? channelsHost : channelsGui;
     
-    if (BENCHMARKING)
-    {
-        ifft->setChannels(CHANNELS);
-        timeDomain->setChannels(CHANNELS);
-    }
+    int channelsEngine = BENCHMARKING ? CHANNELS : channelsIFFT;
+
+    if (singlePrecision)
+        ifftFloat->setChannels(channelsEngine);
     else
-    {
-        ifft->setChannels(channelsIFFT);
-        timeDomain->setChannels(channelsIFFT);
-    }
+        ifftDouble->setChannels(channelsEngine);
+
+    timeDomain->setChannels(channelsEngine);
         
     for (auto i = 0; i < channelsHost; ++i)
     {
         buffer.clear(i, 0, buffer.getNumSamples());
     }
 
+    noteOnFromSilence = false;
+
     for (const auto metadata : midiMessages)
     {
         const auto msg = metadata.getMessage();
         
         if (msg.isNoteOn())
         {  
+            noteOnFromSilence = noteOnFromSilence || gainEnvelope.getState() == ADSR::env_idle;
             ++gateCount;
             gainEnvelope.gate(true);
             signal.setFrequency(static_cast<float>(juce::MidiMessage::getMidiNoteInHertz(msg.getNoteNumber())));
@@ -133,7 +203,7 @@ void PluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     gainEnvelope.setSustainLevel(*gainSustainParameter);
     gainEnvelope.setReleaseRate(*gainReleaseParameter * sampleRate);
     for (int i = 0; i < buffer.getNumSamples(); ++i)
-        gainEnvelopeBuffer[i] = gainEnvelope.process();
+        gainEnvelopeBuffer[i] = static_cast<float>(gainEnvelope.process());
 
     azimuthAngle.setTargetValue(azimuthAngleParameter->load());
     elevationAngle.setTargetValue(elevationAngleParameter->load());
@@ -166,39 +236,183 @@ void PluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
     signal.setAzimuthDisplacement(static_cast<DisplacementFunction>(static_cast<int>(*azimuthDisplacementParameter) - 1), width.getNextValue() * M_PI / 360.0, horizontalDispersion.getNextValue());
     signal.setElevationDisplacement(static_cast<DisplacementFunction>(static_cast<int>(*elevationDisplacementParameter) - 1), height.getNextValue() * M_PI / 360.0, verticalDispersion.getNextValue());
 
-    // Benchmarking Frequency Domain
-    if (FREQDOMAIN)
+    const auto& partials = signal.getPartials();
+    const int numSamples = buffer.getNumSamples();
+
+    // Benchmarking keeps the FREQDOMAIN engine, a running crossfade finishes before the next switch
+    Engine engine = FREQDOMAIN ? Engine::Spectral : Engine::TimeDomain;
+
+    bool handover = false;
+
+    if (HYBRIDENGINE && !BENCHMARKING)
     {
+        const bool crossfading = crossfadePosition < ENGINECROSSFADE;
+        const int partialCount = static_cast<int>(partials.size());
+
+        engine = crossfading ? activeEngine : engineSelector->select(partialCount, channelsEngine, numSamples);
+
+        // A note from silence would wait for the next hop, the oscillators start it at the block,
+        // for dense patches too. Notes over a sounding envelope stay on the IFFT. The selector hands
+        // back to the IFFT with the usual crossfade
+        handover = NOTEONHANDOVER && noteOnFromSilence && (engine == Engine::Spectral || crossfading);
+
+        if (handover)
         {
-            //Timer timer;
-        //if (ifft->getTimer() >= ifft->getHopSize())
-        //{
-            ifft->createSpectrum(signal.getPartials());
-            ifft->IFFTprocess();
+            // The idle envelope silenced the output, so the handover needs no crossfade
+            engine = Engine::TimeDomain;
+            engineSelector->setEngine(engine);
+            crossfadePosition = ENGINECROSSFADE;
+        }
+    }
+
+    if (engine != activeEngine)
+    {
+        activeEngine = engine;
+
+        crossfadePosition = handover ? ENGINECROSSFADE : 0;
+
+        if (activeEngine == Engine::Spectral)
+        {
+            if (singlePrecision)
+                resumeSpectrum(*ifftFloat, partials);
+            else
+                resumeSpectrum(*ifftDouble, partials);
         }
-            //ifft->resetTimer();
-        //}
+    }
+
+    const bool crossfading = crossfadePosition < ENGINECROSSFADE;
+
+    if (activeEngine == Engine::Spectral || crossfading)
+    {
+        if (singlePrecision)
+            processSpectrum(*ifftFloat, partials, buffer, channelsHost, channelsEngine);
+        else
+            processSpectrum(*ifftDouble, partials, buffer, channelsHost, channelsEngine);
     } 
-    else
+
+    if (activeEngine == Engine::TimeDomain || crossfading)
     {
         //Timer timer;
-        timeDomain->process(signal.getPartials());
+        timeDomain->process(partials, numSamples);
+
+        if (crossfading)
+            crossfadeTimeDomain(buffer, channelsHost, channelsIFFT);
+        else
+            writeOutput(timeDomain->bufferArray, buffer, channelsHost, channelsIFFT);
+    }
+}
+
+template <typename T>
+void PluginAudioProcessor::processSpectrum(IFFT<T>& ifft, 
+                                           const std::vector<Partial<float>>& partials, 
+                                           juce::AudioBuffer<float>& buffer, 
+                                           int channelsHost,
+                                           int channelsEngine) noexcept
+{
+    // Stereo hosts only hear the omnidirectional channel. The IFFT renders only the engine channels,
+    // the host channels above them keep the silence of the cleared buffer
+    const int channelsOutput = std::min(channelsHost == 2 ? 1 : channelsHost, channelsEngine);
+    const int numSamples = buffer.getNumSamples();
+
+    int position = 0;
+
+    while (position < numSamples)
+    {
+        if (hopReadPosition == hopLength)
+        {
+            // The adaptive hop is only known once the spectrum is created
+            //Timer timer;
+            ifft.createSpectrum(partials);
+            hopLength = ifft.getHopSize();
+
+            if (numSamples - position >= hopLength)
+            {
+                // A whole hop fits the block: fused straight into the host channels
+                for (int channel = 0; channel < AC; ++channel)
+                    outputChannels[channel] = channel < channelsOutput ? buffer.getWritePointer(channel) + position
+                                                                       : discardBuffer.data() + channel * MAXHOPSIZE;
+
+                ifft.IFFTprocess(outputChannels.data(), gainEnvelopeBuffer.data() + position, hopLength);
+
+                hopReadPosition = hopLength;
+                position += hopLength;
+                continue;
+            }
+
+            ifft.IFFTprocess(hopChannels.data(), nullptr, hopLength);
+            hopReadPosition = 0;
+        }
+
+        const int count = std::min(hopLength - hopReadPosition, numSamples - position);
+
+        for (int channel = 0; channel < channelsOutput; ++channel)
+            juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel) + position,
+                                                  hopBuffer[channel].data() + hopReadPosition,
+                                                  gainEnvelopeBuffer.data() + position,
+                                                  count);
+
+        hopReadPosition += count;
+        position += count;
+    }
+
+    culledPartials = ifft.getCulledPartials();
+
+    if (channelsHost == 2)
+        buffer.copyFrom(1, 0, buffer, 0, 0, buffer.getNumSamples());
+}
+
+template <typename T>
+void PluginAudioProcessor::resumeSpectrum(IFFT<T>& ifft, const std::vector<Partial<float>>& partials) noexcept
+{
+    // The overlap and the FIFO still hold the hop before the pause. One primed hop is discarded,
+    // so the crossfade starts from a complete overlap-add
+    ifft.createSpectrum(partials);
+    hopLength = ifft.getHopSize();
+    ifft.IFFTprocess(hopChannels.data(), nullptr, hopLength);
+    hopReadPosition = hopLength;
+}
+
+void PluginAudioProcessor::crossfadeTimeDomain(juce::AudioBuffer<float>& buffer, 
+                                               int channelsHost, 
+                                               int channelsIFFT) noexcept
+{
+    // The spectral output is already in the buffer, the wavetable output is added along the opposite curve
+    const int numSamples = buffer.getNumSamples();
+    const int channels = channelsHost == 2 ? channelsHost : channelsIFFT;
+    const bool spectralFadesIn = activeEngine == Engine::Spectral;
+
+    for (int channel = 0; channel < channels; ++channel)
+    {
+        float* output = buffer.getWritePointer(channel);
+        const float* source = timeDomain->bufferArray[channelsHost == 2 ? 0 : channel].data();
+
+        for (int sample = 0; sample < numSamples; ++sample)
+        {
+            const int position = std::min(crossfadePosition + sample, ENGINECROSSFADE);
+            const float fadeIn = crossfadeCurve[position];
+            const float fadeOut = crossfadeCurve[ENGINECROSSFADE - position];
+            const float spectralGain = spectralFadesIn ? fadeIn : fadeOut;
+            const float timeDomainGain = spectralFadesIn ? fadeOut : fadeIn;
+
+            output[sample] = output[sample] * spectralGain + source[sample] * gainEnvelopeBuffer[sample] * timeDomainGain;
+        }
     }
 
-    //int offset = ifft->getTimer();
-   
+    crossfadePosition = std::min(crossfadePosition + numSamples, ENGINECROSSFADE);
+}
+
+template <typename T>
+void PluginAudioProcessor::writeOutput(const std::array<std::vector<T>, AC>& source, 
+                                       juce::AudioBuffer<float>& buffer, 
+                                       int channelsHost, 
+                                       int channelsIFFT) noexcept
+{
     if (channelsHost == 2)
     {
         for (int channel = 0; channel < channelsHost; ++channel)
         {
             for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-            {
-                if (FREQDOMAIN)
-                    buffer.setSample(channel, sample, static_cast<float>(ifft->bufferArray[0][sample] * gainEnvelopeBuffer[sample]));
-                    //buffer.setSample(channel, sample, static_cast<float>(ifft->bufferArray[0][offset + sample] * gainEnvelopeBuffer[sample]));
-                else
-                    buffer.setSample(channel, sample, timeDomain->bufferArray[0][sample] * gainEnvelopeBuffer[sample]);
-            }
+                buffer.setSample(channel, sample, static_cast<float>(source[0][sample] * gainEnvelopeBuffer[sample]));
         }
     }
     else
@@ -206,17 +420,9 @@ void PluginAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::
         for (int channel = 0; channel < channelsIFFT; ++channel)
         {
             for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
-            {
-                if (FREQDOMAIN)
-                    buffer.setSample(channel, sample, static_cast<float>(ifft->bufferArray[channel][sample] * gainEnvelopeBuffer[sample]));
-                    //buffer.setSample(channel, sample, static_cast<float>(ifft->bufferArray[channel][offset + sample] * gainEnvelopeBuffer[sample]));
-                else
-                    buffer.setSample(channel, sample, timeDomain->bufferArray[channel][sample] * gainEnvelopeBuffer[sample]);
-            }
+                buffer.setSample(channel, sample, static_cast<float>(source[channel][sample] * gainEnvelopeBuffer[sample]));
         }
     } 
-    
-    //ifft->setTimer(ifft->getTimer() + buffer.getNumSamples());
 }
 
 juce::AudioProcessor::BusesProperties PluginAudioProcessor::getBuses()
@@ -243,7 +449,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout PluginAudioProcessor::create
     juce::AudioProcessorValueTreeState::ParameterLayout params;
     
     params.add(std::make_unique<juce::AudioParameterInt>("waveform", "Waveform", 1, 5, 5)); 
-    params.add(std::make_unique<juce::AudioParameterInt>("noiseDensity", "Noise Density", 1, 10000, 1000));
+    params.add(std::make_unique<juce::AudioParameterInt>("noiseDensity", "Noise Density", 1, MAXPARTIALS, 1000));
     params.add(std::make_unique<juce::AudioParameterFloat>("brightness", "Brightness", juce::NormalisableRange<float>(0.5, 250.0, 0.01, 0.2), 10.0));
     params.add(std::make_unique<juce::AudioParameterFloat>("distance", "Distance", juce::NormalisableRange<float>(1.0, 100.0, 0.01, 0.3), 1.0));
     params.add(std::make_unique<juce::AudioParameterFloat>("azimuthAngle", "Azimuth Angle", -180.0, 180.0, 0.0));
@@ -4,16 +4,38 @@
 #include <shared_plugin_helpers/shared_plugin_helpers.h>
 #include "IFFT.hpp"
 #include "TimeDomain.hpp"
+#include "EngineSelector.hpp"
 #include "ADSR.hpp"
 #include "Timer.hpp"
 
 /**** Benchmarking Constants ****/
 const bool BENCHMARKING = false;
-const bool FREQDOMAIN = true; // false => time domain
+const bool FREQDOMAIN = true; // false => time domain, used when benchmarking or without HYBRIDENGINE
 const int PARTIALS = 10000;
 const int CHANNELS = 16;
 /********************************/
 
+/******* Engine Constants *******/
+const bool SINGLEPRECISION = true; // false => IFFT<double>
+const bool LOWLATENCY = false; // 256 sample frames: a quarter of the onset delay for four times the spectra per second, see SNR_Onset and SNR_FrameSize
+const int FRAMESIZE = LOWLATENCY ? 256 : 1024; // IFFT frame in samples, independent of the host block size
+const int OVERLAPFACTOR = 4; // 2, 4 or 8 spectra per frame, 2 => least CPU, 8 => finest parameter updates
+const int HOPSIZE = FRAMESIZE / OVERLAPFACTOR;
+const bool ADAPTIVEHOP = false; // 2 * HOPSIZE while the partials hold still, needs OVERLAPFACTOR 8
+const int MAXHOPSIZE = ADAPTIVEHOP ? 2 * HOPSIZE : HOPSIZE;
+static_assert(!ADAPTIVEHOP || OVERLAPFACTOR == 8, "ADAPTIVEHOP needs OVERLAPFACTOR 8");
+const int MAXPARTIALS = 10000; // Upper end of the noise density parameter, the engine's per partial state is allocated up front
+const int WORKERTHREADS = 1; // Threads for the channel IFFTs and overlap-add, 1 => audio thread only
+const bool DIRECTIONBUCKETING = true; // One IFFT per direction bucket when cheaper than the channel splat
+const float DIRECTIONERROR = 0.0f; // Angular error budget of the buckets in degrees, 0 => identical directions only
+const float MOTIFNOISEFLOOR = -80.0f; // dB below the signal the narrowed motifs of quiet partials may add, 0 => full motif for every partial
+const float CULLINGTHRESHOLD = -120.0f; // dBFS below which partials are not synthesised, e.g. the high partials of dull patches
+const float MASKINGTHRESHOLD = 0.0f; // dB below the loudest partial of a critical band from which partials are culled, 0 => no masking
+const bool HYBRIDENGINE = true; // IFFT or TimeDomain per block, whichever the EngineSelector cost model finds cheaper
+const int ENGINECROSSFADE = 512; // Samples of the equal-power crossfade when the hybrid engine switches
+const bool NOTEONHANDOVER = true; // With HYBRIDENGINE: notes from silence start on the TimeDomain engine, sample accurate, and are handed to the IFFT
+/********************************/
+
 class PluginAudioProcessor : public PluginHelpers::ProcessorBase,
                              private juce::AsyncUpdater,
                              private juce::Thread
@@ -35,6 +57,9 @@ public:
     void handleAsyncUpdate() override;
 
     int gateCount;
+    bool noteOnFromSilence; // A note-on of this block found the gain envelope idle
+
+    std::atomic<int> culledPartials; // Partials the IFFT culled in the last block it rendered
 
 private:
     static juce::AudioProcessor::BusesProperties getBuses();
@@ -43,12 +68,32 @@ private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParameters();
 
     BasicSignals signal;
-    IFFT* ifft;
+    std::unique_ptr<IFFT<float>> ifftFloat;
+    std::unique_ptr<IFFT<double>> ifftDouble;
+    bool singlePrecision;
     
     ADSR gainEnvelope;
-    std::vector<double> gainEnvelopeBuffer;
+    std::vector<float> gainEnvelopeBuffer;
+
+    // Host channel pointers for the fused IFFT output, channels the host lacks write to a slice of discardBuffer
+    std::array<float*, AC> outputChannels;
+    std::vector<float> discardBuffer;
+
+    // Output FIFO: a hop that straddles host blocks is rendered here and drained over the following blocks.
+    // hopLength is the IFFT's hop when it was rendered, which the adaptive hop may vary
+    std::array<std::vector<float>, AC> hopBuffer;
+    std::array<float*, AC> hopChannels;
+    int hopLength;
+    int hopReadPosition;
+
+    std::unique_ptr<TimeDomain> timeDomain;
 
-    TimeDomain* timeDomain;
+    // Hybrid engine: while crossfadePosition < ENGINECROSSFADE both engines render,
+    // activeEngine fades in and the other one out along crossfadeCurve
+    std::unique_ptr<EngineSelector> engineSelector;
+    Engine activeEngine;
+    int crossfadePosition;
+    std::vector<float> crossfadeCurve;
     
     juce::LinearSmoothedValue<float> elevationAngle { 0.0 };
     juce::LinearSmoothedValue<float> azimuthAngle { 0.0 };
@@ -77,4 +122,28 @@ private:
     std::atomic<float>* gainReleaseParameter = nullptr;
     
     void run() override;
+
+    // Engine settings of PluginProcessor.h, shared by both precisions
+    template <typename T>
+    void configureIFFT(IFFT<T>& ifft, double sampleRate);
+
+    template <typename T>
+    void processSpectrum(IFFT<T>& ifft, 
+                         const std::vector<Partial<float>>& partials, 
+                         juce::AudioBuffer<float>& buffer, 
+                         int channelsHost,
+                         int channelsEngine) noexcept;
+
+    template <typename T>
+    void resumeSpectrum(IFFT<T>& ifft, const std::vector<Partial<float>>& partials) noexcept;
+
+    void crossfadeTimeDomain(juce::AudioBuffer<float>& buffer, 
+                             int channelsHost, 
+                             int channelsIFFT) noexcept;
+
+    template <typename T>
+    void writeOutput(const std::array<std::vector<T>, AC>& source, 
+                     juce::AudioBuffer<float>& buffer, 
+                     int channelsHost, 
+                     int channelsIFFT) noexcept;
 };
@@ -10,17 +10,22 @@ SpectralMotif<T>::SpectralMotif (WindowType type,
       m_oversamplingFactor(oversampling),
       m_K(bins),     
       m_windowSize(m_frameSize * m_oversamplingFactor),
-      m_middleIndex(m_oversamplingFactor * (m_K + 1)),
+      m_halfSize(m_oversamplingFactor * (m_K + 1) + 1),
+      m_interpolation(MotifInterpolation::Cubic),
+      m_phaseCount(POLYPHASE_FACTOR * m_oversamplingFactor),
+      m_polyphaseStride(0),
       m_plan(m_windowSize),
       m_temp(m_plan.temp_size)
 {
-    m_spectralMotifComplex.resize(2 * m_middleIndex, std::complex<T>(0.0, 0.0));
-    m_spectralMotifReal.resize(2 * m_middleIndex, 0.0);
+    m_halfMotif.resize(m_halfSize + 3, 0.0);
 
     m_fftInput.resize(m_windowSize, kfr::complex<T>(0.0, 0.0));
     m_fftOutput.resize(m_windowSize, kfr::complex<T>(0.0, 0.0));
-    m_complexOutput.reserve(m_windowSize);
-    m_realOutput.reserve(m_windowSize);
+
+    // Rows padded to whole cache lines, so every row starts aligned
+    const int lineValues = POLYPHASE_ALIGNMENT / static_cast<int>(sizeof(T));
+    m_polyphaseStride = (2 * m_K + 1 + lineValues - 1) / lineValues * lineValues;
+    m_polyphase.resize((m_phaseCount + 1) * m_polyphaseStride, 0.0);
 
     createSpectralMotif();
 }
@@ -45,47 +50,58 @@ void SpectralMotif<T>::createSpectralMotif()
     
     m_plan.execute(m_fftOutput, m_fftInput, m_temp, false); 
 
-    // Set only the mainlobe  
-    for (int i = 0; i < m_middleIndex; ++i)
-    {
-        m_spectralMotifComplex[m_middleIndex + i] = std::complex<T>(m_fftOutput[i].real(), m_fftOutput[i].imag());
-        m_spectralMotifComplex[i] = std::complex<T>(m_fftOutput[m_windowSize - m_middleIndex + i].real(), m_fftOutput[m_windowSize - m_middleIndex + i].imag());
+    // Set only the positive half of the mainlobe, the window is zero-phase so the motif is real and even
+    m_halfMotif[0] = m_fftOutput[1].real();
 
-        m_spectralMotifReal[m_middleIndex + i] = m_fftOutput[i].real();
-        m_spectralMotifReal[i] = m_fftOutput[m_windowSize - m_middleIndex + i].real();
-    }
+    for (int i = 0; i < m_halfSize + 2; ++i)
+        m_halfMotif[i + 1] = m_fftOutput[i].real();
 
-    //std::cout << m_spectralMotifComplex[m_middleIndex].imag() << "\n";
+    createPolyphaseTable();
 }
 
 template <typename T>
-std::complex<T> SpectralMotif<T>::getComplexValueAtIndex(int index)
+void SpectralMotif<T>::createPolyphaseTable() noexcept
 {
-    return m_spectralMotifComplex[index];
-}
+    for (int row = 0; row <= m_phaseCount; ++row)
+    {
+        const T remainder = static_cast<T>(row) / m_phaseCount - static_cast<T>(0.5);
 
-template <typename T>
-std::vector<std::complex<T>> SpectralMotif<T>::getSpectralMotifComplex()
-{
-   return m_spectralMotifComplex; 
-}
+        for (int j = -m_K; j <= m_K; ++j)
+            m_polyphase[row * m_polyphaseStride + j + m_K] = getValue(remainder + j);
+    }
 
-template <typename T>
-T SpectralMotif<T>::getRealValueAtIndex(int index)
-{
-    return m_spectralMotifReal[index];
+    m_truncationErrors.assign(m_K + 1, 0.0);
+
+    for (int row = 0; row <= m_phaseCount; ++row)
+    {
+        const T* coefficients = m_polyphase.data() + row * m_polyphaseStride;
+        T energy = 0.0;
+
+        for (int j = 0; j < 2 * m_K + 1; ++j)
+            energy += coefficients[j] * coefficients[j];
+
+        // Energy beyond +-bins, accumulated from the outermost pair inwards
+        T tail = 0.0;
+
+        for (int bins = m_K - 1; bins >= 0; --bins)
+        {
+            tail += coefficients[m_K - bins - 1] * coefficients[m_K - bins - 1] + coefficients[m_K + bins + 1] * coefficients[m_K + bins + 1];
+            m_truncationErrors[bins] = std::max(m_truncationErrors[bins], std::sqrt(tail / energy));
+        }
+    }
 }
 
 template <typename T>
-std::vector<T> SpectralMotif<T>::getSpectralMotifReal()
+void SpectralMotif<T>::setInterpolation(MotifInterpolation interpolation) noexcept
 {
-   return m_spectralMotifReal; 
+    m_interpolation = interpolation;
+    createPolyphaseTable();
 }
 
 template <typename T>
-int SpectralMotif<T>::getMiddleIndex()
+std::vector<T> SpectralMotif<T>::getSpectralMotifReal()
 {
-    return m_middleIndex;
+   return std::vector<T>(m_halfMotif.begin() + 1, m_halfMotif.begin() + 1 + m_halfSize); 
 }
 
 template class SpectralMotif<float>;
@@ -0,0 +1,297 @@
+/**
+ * \class SpectralSplat
+ *
+ *
+ * \brief Vectorized kernels that add a weighted spectral motif into the channel spectra.
+ *
+ * A partial contributes the same 2K+1 complex motif coefficients to every
+ * ambisonic channel, only scaled by the channel's B-format weight. The
+ * coefficients are computed once per partial and the kernel then adds
+ * weight * coefficients into all active channels in one call. Each channel
+ * row is contiguous, so the kernel runs along the interleaved real/imaginary
+ * values of the motif with AVX-512, AVX2 or a scalar fallback, depending on
+ * the instruction set the translation unit is compiled for.
+ *
+ * For the interleaved spectrum layout the channels of one bin are
+ * contiguous. splatInterleaved() then vectorizes across the channels of a
+ * block instead, one register per motif bin.
+ *
+ *
+ * \author Hilko Tondock
+ *
+ * \version  0.1
+ *
+ * \date   2023/03/31
+ *
+ * Contact: h.tondock@campus.tu-berlin.de
+ *
+ */
+
+#pragma once
+
+#include <complex>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+
+template <typename T>
+class SpectralSplat
+{
+public:
+    // Adds weights[c] * coefficients[0 .. width) to rows[c][firstBin .. firstBin + width) for all channels
+    static void splatPartial(std::complex<T>* const* rows,
+                             int firstBin,
+                             const std::complex<T>* coefficients,
+                             int width,
+                             const T* weights,
+                             int channels) noexcept
+    {
+        const T* source = reinterpret_cast<const T*>(coefficients);
+        const int length = 2 * width;
+
+        for (int c = 0; c < channels; ++c)
+            accumulate(reinterpret_cast<T*>(rows[c] + firstBin), source, weights[c], length);
+    }
+
+    // destination[i] += weight * source[i]
+    static void accumulate(T* destination, const T* source, T weight, int length) noexcept;
+
+    // Adds weights[l] * row[k] to destination[k * stride + l] for all motif bins k.
+    // The weights hold each channel's B-format value twice (real and imaginary lane),
+    // lanes is twice the number of channels in the block.
+    static void splatInterleaved(T* destination,
+                                 int stride,
+                                 const T* weights,
+                                 const std::complex<T>* row,
+                                 int width,
+                                 int lanes) noexcept;
+
+    static void splatInterleavedScalar(T* destination,
+                                       int stride,
+                                       const T* weights,
+                                       const std::complex<T>* row,
+                                       int width,
+                                       int lanes) noexcept
+    {
+        for (int k = 0; k < width; ++k)
+        {
+            T* bin = destination + k * stride;
+            const T real = row[k].real();
+            const T imag = row[k].imag();
+
+            for (int l = 0; l < lanes; l += 2)
+            {
+                bin[l] += weights[l] * real;
+                bin[l + 1] += weights[l + 1] * imag;
+            }
+        }
+    }
+
+    static void accumulateScalar(T* destination, const T* source, T weight, int length) noexcept
+    {
+        for (int i = 0; i < length; ++i)
+            destination[i] += weight * source[i];
+    }
+
+    static constexpr bool isVectorized() noexcept
+    {
+    #if defined(__AVX512F__) || defined(__AVX2__)
+        return true;
+    #else
+        return false;
+    #endif
+    }
+
+    static const char* getInstructionSet() noexcept
+    {
+    #if defined(__AVX512F__)
+        return "AVX-512";
+    #elif defined(__AVX2__)
+        return "AVX2";
+    #else
+        return "Scalar";
+    #endif
+    }
+};
+
+// The motif rows are short (2 * (2K+1) values), so the remainder is handled with
+// masked loads and stores instead of a scalar tail loop.
+
+#if defined(__AVX2__) && !defined(__AVX512F__)
+alignas(32) static const int splatTailMask[16] = { -1, -1, -1, -1, -1, -1, -1, -1, 0, 0, 0, 0, 0, 0, 0, 0 };
+#endif
+
+template <>
+inline void SpectralSplat<float>::accumulate(float* destination, const float* source, float weight, int length) noexcept
+{
+#if defined(__AVX512F__)
+    const __m512 w = _mm512_set1_ps(weight);
+    int i = 0;
+
+    for (; i + 16 <= length; i += 16)
+        _mm512_storeu_ps(destination + i, _mm512_fmadd_ps(w, _mm512_loadu_ps(source + i), _mm512_loadu_ps(destination + i)));
+
+    if (i < length)
+    {
+        const __mmask16 mask = static_cast<__mmask16>((1u << (length - i)) - 1u);
+        const __m512 sum = _mm512_fmadd_ps(w, _mm512_maskz_loadu_ps(mask, source + i), _mm512_maskz_loadu_ps(mask, destination + i));
+        _mm512_mask_storeu_ps(destination + i, mask, sum);
+    }
+#elif defined(__AVX2__)
+    const __m256 w = _mm256_set1_ps(weight);
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8)
+        _mm256_storeu_ps(destination + i, _mm256_add_ps(_mm256_loadu_ps(destination + i), _mm256_mul_ps(w, _mm256_loadu_ps(source + i))));
+
+    if (i < length)
+    {
+        const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(splatTailMask + 8 - (length - i)));
+        const __m256 sum = _mm256_add_ps(_mm256_maskload_ps(destination + i, mask), _mm256_mul_ps(w, _mm256_maskload_ps(source + i, mask)));
+        _mm256_maskstore_ps(destination + i, mask, sum);
+    }
+#else
+    accumulateScalar(destination, source, weight, length);
+#endif
+}
+
+template <>
+inline void SpectralSplat<double>::accumulate(double* destination, const double* source, double weight, int length) noexcept
+{
+#if defined(__AVX512F__)
+    const __m512d w = _mm512_set1_pd(weight);
+    int i = 0;
+
+    for (; i + 8 <= length; i += 8)
+        _mm512_storeu_pd(destination + i, _mm512_fmadd_pd(w, _mm512_loadu_pd(source + i), _mm512_loadu_pd(destination + i)));
+
+    if (i < length)
+    {
+        const __mmask8 mask = static_cast<__mmask8>((1u << (length - i)) - 1u);
+        const __m512d sum = _mm512_fmadd_pd(w, _mm512_maskz_loadu_pd(mask, source + i), _mm512_maskz_loadu_pd(mask, destination + i));
+        _mm512_mask_storeu_pd(destination + i, mask, sum);
+    }
+#elif defined(__AVX2__)
+    const __m256d w = _mm256_set1_pd(weight);
+    int i = 0;
+
+    for (; i + 4 <= length; i += 4)
+        _mm256_storeu_pd(destination + i, _mm256_add_pd(_mm256_loadu_pd(destination + i), _mm256_mul_pd(w, _mm256_loadu_pd(source + i))));
+
+    if (i < length)
+    {
+        // Two mask lanes per double
+        const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(splatTailMask + 8 - 2 * (length - i)));
+        const __m256d sum = _mm256_add_pd(_mm256_maskload_pd(destination + i, mask), _mm256_mul_pd(w, _mm256_maskload_pd(source + i, mask)));
+        _mm256_maskstore_pd(destination + i, mask, sum);
+    }
+#else
+    accumulateScalar(destination, source, weight, length);
+#endif
+}
+
+template <>
+inline void SpectralSplat<float>::splatInterleaved(float* destination,
+                                                   int stride,
+                                                   const float* weights,
+                                                   const std::complex<float>* row,
+                                                   int width,
+                                                   int lanes) noexcept
+{
+#if defined(__AVX512F__)
+    const int full = lanes & ~15;
+    const __mmask16 mask = static_cast<__mmask16>((1u << (lanes - full)) - 1u);
+
+    for (int k = 0; k < width; ++k)
+    {
+        // (real, imag) pair of the motif bin in every lane pair
+        const float re = row[k].real(), im = row[k].imag();
+        const __m512 coefficient = _mm512_setr4_ps(re, im, re, im);
+        float* bin = destination + k * stride;
+        int l = 0;
+
+        for (; l < full; l += 16)
+            _mm512_storeu_ps(bin + l, _mm512_fmadd_ps(_mm512_loadu_ps(weights + l), coefficient, _mm512_loadu_ps(bin + l)));
+
+        if (l < lanes)
+        {
+            const __m512 sum = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(mask, weights + l), coefficient, _mm512_maskz_loadu_ps(mask, bin + l));
+            _mm512_mask_storeu_ps(bin + l, mask, sum);
+        }
+    }
+#elif defined(__AVX2__)
+    const int full = lanes & ~7;
+    const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(splatTailMask + 8 - (lanes - full)));
+
+    for (int k = 0; k < width; ++k)
+    {
+        const __m256 coefficient = _mm256_castpd_ps(_mm256_broadcast_sd(reinterpret_cast<const double*>(row + k)));
+        float* bin = destination + k * stride;
+        int l = 0;
+
+        for (; l < full; l += 8)
+            _mm256_storeu_ps(bin + l, _mm256_add_ps(_mm256_loadu_ps(bin + l), _mm256_mul_ps(_mm256_loadu_ps(weights + l), coefficient)));
+
+        if (l < lanes)
+        {
+            const __m256 sum = _mm256_add_ps(_mm256_maskload_ps(bin + l, mask), _mm256_mul_ps(_mm256_maskload_ps(weights + l, mask), coefficient));
+            _mm256_maskstore_ps(bin + l, mask, sum);
+        }
+    }
+#else
+    splatInterleavedScalar(destination, stride, weights, row, width, lanes);
+#endif
+}
+
+template <>
+inline void SpectralSplat<double>::splatInterleaved(double* destination,
+                                                    int stride,
+                                                    const double* weights,
+                                                    const std::complex<double>* row,
+                                                    int width,
+                                                    int lanes) noexcept
+{
+#if defined(__AVX512F__)
+    const int full = lanes & ~7;
+    const __mmask8 mask = static_cast<__mmask8>((1u << (lanes - full)) - 1u);
+
+    for (int k = 0; k < width; ++k)
+    {
+        const double re = row[k].real(), im = row[k].imag();
+        const __m512d coefficient = _mm512_setr4_pd(re, im, re, im);
+        double* bin = destination + k * stride;
+        int l = 0;
+
+        for (; l < full; l += 8)
+            _mm512_storeu_pd(bin + l, _mm512_fmadd_pd(_mm512_loadu_pd(weights + l), coefficient, _mm512_loadu_pd(bin + l)));
+
+        if (l < lanes)
+        {
+            const __m512d sum = _mm512_fmadd_pd(_mm512_maskz_loadu_pd(mask, weights + l), coefficient, _mm512_maskz_loadu_pd(mask, bin + l));
+            _mm512_mask_storeu_pd(bin + l, mask, sum);
+        }
+    }
+#elif defined(__AVX2__)
+    const int full = lanes & ~3;
+    const __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(splatTailMask + 8 - 2 * (lanes - full)));
+
+    for (int k = 0; k < width; ++k)
+    {
+        const __m256d coefficient = _mm256_broadcast_pd(reinterpret_cast<const __m128d*>(row + k));
+        double* bin = destination + k * stride;
+        int l = 0;
+
+        for (; l < full; l += 4)
+            _mm256_storeu_pd(bin + l, _mm256_add_pd(_mm256_loadu_pd(bin + l), _mm256_mul_pd(_mm256_loadu_pd(weights + l), coefficient)));
+
+        if (l < lanes)
+        {
+            const __m256d sum = _mm256_add_pd(_mm256_maskload_pd(bin + l, mask), _mm256_mul_pd(_mm256_maskload_pd(weights + l, mask), coefficient));
+            _mm256_maskstore_pd(bin + l, mask, sum);
+        }
+    }
+#else
+    splatInterleavedScalar(destination, stride, weights, row, width, lanes);
+#endif
+}
@@ -19,19 +19,23 @@ TimeDomain::TimeDomain(int bufferSize, float sampleRate)
     }
 }
 
-void TimeDomain::process(const std::vector<Partial<float>>& partials) noexcept
+void TimeDomain::process(const std::vector<Partial<float>>& partials, int numSamples) noexcept
 {
+    numSamples = std::min(numSamples, m_bufferSize);
+
     for (auto& buffer: bufferArray)
     {
-        std::fill(buffer.begin(), buffer.end(), 0.0);
+        std::fill(buffer.begin(), buffer.begin() + numSamples, 0.0);
     }
     
-    for (int partial = 0; partial < partials.size(); ++partial)
+    const int partialCount = std::min(static_cast<int>(partials.size()), TIMEDOMAIN_OSCILLATORS);
+
+    for (int partial = 0; partial < partialCount; ++partial)
     {
         float currentAmplitude = partials[partial].amplitude;
         oscillatorArray[partial]->setFrequency(partials[partial].frequency, m_sampleRate);
 
-        for (int sample = 0; sample < oscillatorArray[0]->buffer.size(); ++sample)
+        for (int sample = 0; sample < numSamples; ++sample)
         {
             oscillatorArray[partial]->buffer[sample] = currentAmplitude * oscillatorArray[partial]->getNextSample();
         }
@@ -40,7 +44,7 @@ void TimeDomain::process(const std::vector<Partial<float>>& partials) noexcept
         {
             float bFormat = partials[partial].bFormat[buffer];
 
-            for (int sample = 0; sample < bufferArray[0].size(); ++sample)
+            for (int sample = 0; sample < numSamples; ++sample)
             {
                 bufferArray[buffer][sample] += bFormat * oscillatorArray[partial]->buffer[sample];
             }
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <vector>
 
@@ -28,6 +29,8 @@
 #include "WavetableSineOscillator.hpp"
 #include "BasicSignals.hpp"
 
+const int TIMEDOMAIN_OSCILLATORS = 10000; // One oscillator per partial
+
 class TimeDomain
 {
 public:
@@ -35,9 +38,10 @@ public:
 
     std::array<std::vector<float>, 16> bufferArray;
 
-    std::array<WavetableOscillator*, 10000> oscillatorArray;
+    std::array<WavetableOscillator*, TIMEDOMAIN_OSCILLATORS> oscillatorArray;
 
-    void process(const std::vector<Partial<float>>& partials) noexcept; 
+    // Renders numSamples (at most the bufferSize of the constructor) into bufferArray
+    void process(const std::vector<Partial<float>>& partials, int numSamples) noexcept; 
     
     void setChannels(int channels);
     
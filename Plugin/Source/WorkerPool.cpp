@@ -0,0 +1,137 @@
+#include "WorkerPool.hpp"
+
+#include <chrono>
+
+#if defined(__linux__) || defined(__APPLE__)
+    #include <pthread.h>
+    #include <sched.h>
+#endif
+
+// Idle workers spin this long after their last task, covering the batches of one block, then wait.
+// The timeout of the wait bounds a wake-up that raced with the notification
+const std::chrono::microseconds spinTime(50);
+const std::chrono::microseconds waitTime(1000);
+
+WorkerPool::WorkerPool(int threads)
+    : m_claim(0),
+      m_pendingTasks(0),
+      m_task(nullptr),
+      m_context(nullptr),
+      m_exit(false),
+      m_sleepingWorkers(0)
+{
+    for (int worker = 1; worker < threads; ++worker)
+        m_threads.emplace_back(&WorkerPool::workerLoop, this, worker);
+}
+
+WorkerPool::~WorkerPool()
+{
+    m_exit.store(true);
+
+    {
+        std::lock_guard<std::mutex> lock(m_wakeMutex);
+        m_wake.notify_all();
+    }
+
+    for (auto& thread: m_threads)
+        thread.join();
+}
+
+void WorkerPool::run(Task task, void* context, int taskCount) noexcept
+{
+    if (taskCount <= 0)
+        return;
+
+    // Hosts may move the callback to another thread, only then the priority is read again
+    if (std::this_thread::get_id() != m_caller)
+    {
+        m_caller = std::this_thread::get_id();
+        matchCallerPriority();
+    }
+
+    m_task = task;
+    m_context = context;
+    m_pendingTasks.store(taskCount, std::memory_order_relaxed);
+
+    // Hand-off: a single store publishes the whole batch
+    m_claim.store(static_cast<std::uint64_t>(taskCount) << 32, std::memory_order_seq_cst);
+
+    if (m_sleepingWorkers.load(std::memory_order_seq_cst) > 0)
+        m_wake.notify_all();
+
+    while (runNextTask(0)) {}
+
+    // Join: wait for tasks that workers claimed but have not finished yet
+    while (m_pendingTasks.load(std::memory_order_acquire) > 0)
+        std::this_thread::yield();
+}
+
+bool WorkerPool::runNextTask(int worker) noexcept
+{
+    std::uint64_t claim = m_claim.load(std::memory_order_acquire);
+
+    while (static_cast<std::uint32_t>(claim) < static_cast<std::uint32_t>(claim >> 32))
+    {
+        if (m_claim.compare_exchange_weak(claim, claim + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            // The batch cannot be replaced before this task has finished
+            m_task(m_context, static_cast<int>(static_cast<std::uint32_t>(claim)), worker);
+            m_pendingTasks.fetch_sub(1, std::memory_order_acq_rel);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool WorkerPool::hasTask() const noexcept
+{
+    const std::uint64_t claim = m_claim.load(std::memory_order_seq_cst);
+
+    return static_cast<std::uint32_t>(claim) < static_cast<std::uint32_t>(claim >> 32);
+}
+
+void WorkerPool::workerLoop(int worker) noexcept
+{
+    auto lastTask = std::chrono::steady_clock::now();
+
+    while (!m_exit.load(std::memory_order_relaxed))
+    {
+        if (runNextTask(worker))
+        {
+            lastTask = std::chrono::steady_clock::now();
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() - lastTask < spinTime)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Registered before the last check, so run() either sees a sleeper or the check sees the batch
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+
+        if (!hasTask() && !m_exit.load(std::memory_order_relaxed))
+            m_wake.wait_for(lock, waitTime);
+
+        m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void WorkerPool::matchCallerPriority() noexcept
+{
+    // Never above the caller, so the workers cannot starve the audio thread or other plugins
+#if defined(__linux__) || defined(__APPLE__)
+    int policy;
+    sched_param parameters {};
+
+    if (pthread_getschedparam(pthread_self(), &policy, &parameters) != 0)
+        return;
+
+    for (auto& thread: m_threads)
+        pthread_setschedparam(thread.native_handle(), policy, &parameters);
+#endif
+}
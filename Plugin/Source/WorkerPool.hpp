@@ -0,0 +1,81 @@
+/**
+ * \class WorkerPool
+ *
+ *
+ * \brief A small pool of pre-spawned worker threads for the audio thread.
+ *
+ * run() hands a batch of independent tasks to the workers with a single
+ * atomic store, takes part in the work itself and returns once every task
+ * has finished. The audio thread never locks or allocates: idle workers
+ * spin and yield briefly after each batch, then wait on a condition
+ * variable that run() notifies without taking its mutex. A task a worker
+ * has not picked up yet is simply run by the calling thread, so a missed
+ * wake-up costs parallelism, never a result. The workers take the
+ * scheduling policy and priority of the thread that calls run(), so they
+ * never preempt the audio thread they serve.
+ *
+ *
+ * \author Hilko Tondock
+ *
+ * \version  0.1
+ *
+ * \date   2023/03/31
+ *
+ * Contact: h.tondock@campus.tu-berlin.de
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool
+{
+public:
+    // task(context, taskIndex, workerIndex), worker 0 is the calling thread
+    using Task = void (*)(void*, int, int);
+
+    // threads includes the calling thread, so threads - 1 workers are spawned
+    explicit WorkerPool(int threads);
+
+    ~WorkerPool();
+
+    void run(Task task, void* context, int taskCount) noexcept;
+
+    int getThreadCount() const noexcept;
+
+private:
+    std::vector<std::thread> m_threads;
+
+    // Task count in the upper, next task index in the lower 32 bits. A task is
+    // claimed by one compare-exchange, so a stale worker can never claim a task
+    // of a finished batch.
+    std::atomic<std::uint64_t> m_claim;
+    std::atomic<int> m_pendingTasks;
+    Task m_task;
+    void* m_context;
+    std::atomic<bool> m_exit;
+
+    // Idle workers wait here, run() only notifies while m_sleepingWorkers > 0
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_sleepingWorkers;
+
+    std::thread::id m_caller; // Thread whose priority the workers have
+
+    bool runNextTask(int worker) noexcept;
+
+    bool hasTask() const noexcept;
+
+    void workerLoop(int worker) noexcept;
+
+    // Gives the workers the scheduling policy and priority of the calling thread, best effort
+    void matchCallerPriority() noexcept;
+};
+
+inline int WorkerPool::getThreadCount() const noexcept { return static_cast<int>(m_threads.size()) + 1; }
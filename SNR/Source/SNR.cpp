@@ -2,22 +2,288 @@
 #include <vector>
 #include <string>
 #include <fstream>
+#include <chrono>
+#include <random>
 
 #include <shared_processing_code/shared_processing_code.h>
 #include "../../Plugin/Source/IFFT.hpp"
 
 const bool SNR_K = true; // SNR_K = true: K and the windows are measured, SNR_K = false: The oversampling factor is scrutinized
+const bool SNR_OVERLAP = true; // Accuracy and cost of the overlap factors 2, 4 and 8
+const bool SNR_LOD = true; // Total error and motif bins of the amplitude driven motif width
+const bool SNR_ONSET = true; // Delay from a note-on to the spectral onset per frame size and overlap factor
+const bool SNR_ADAPTIVE = true; // Accuracy and spectra per second of the adaptive hop
+const bool SNR_FRAMESIZE = true; // Accuracy over frequency and cost over partial count of the 256 sample LOWLATENCY frames
 const double sampleRate = 48000.0;
 const int bufferSize = 256;
 const int bufferCount = 8;
 
+// Renders a sine through IFFT<T> and compares it against a double precision reference
+template <typename T>
+double measureSNR(const std::vector<Partial<float>>& signalData,
+                  WindowType windowType,
+                  int oversamplingFactor,
+                  int K,
+                  double frequency,
+                  int overlapFactor,
+                  MotifInterpolation interpolation)
+{
+    // The frame stays 4 * bufferSize, the overlap factor only changes the hop
+    const int hopSize = 4 * bufferSize / overlapFactor;
+    const int sampleCount = bufferCount * bufferSize;
+
+    std::vector<double> referenceData;
+    std::vector<double> ifftData;
+    referenceData.resize(sampleCount);
+    ifftData.resize(sampleCount); 
+
+    // Create IFFT data
+    IFFT<T> ifft = IFFT<T>(4 * bufferSize, overlapFactor, windowType, oversamplingFactor, K);
+    ifft.setSampleRate(sampleRate);
+    ifft.setMotifInterpolation(interpolation);
+
+    for (int i = 0; i < sampleCount / hopSize; ++i)
+    {     
+        ifft.createSpectrum(signalData);
+        ifft.IFFTprocess();
+        
+        for (int j = 0; j < hopSize; ++j)
+        {
+            ifftData[i * hopSize + j] = ifft.bufferArray[0][j];
+        }
+    }
+    
+    // Calculate Energy of signal and noise and compare signals
+    double signalEnergy = 0.0;
+    double noiseEnergy = 0.0;
+    double signalDifference = 0.0;
+
+    // Start reference data at the initial phase of IFFT data
+    double currentAngle = std::fmod(2 * M_PI * frequency * 0.5 * hopSize * 1.0 / sampleRate, 2 * M_PI);
+
+    double angleDelta = frequency / sampleRate * 2 * M_PI;
+
+    for (int i = 0; i < sampleCount - hopSize; ++i)
+    {     
+        referenceData[hopSize + i] = std::cos(currentAngle);
+        currentAngle += angleDelta;
+        if (currentAngle >= 2 * M_PI)
+            currentAngle -= 2 * M_PI;
+        
+        // First hop is discarded because there is no overlap data yet
+        
+        // Calculate Energy of signal
+        signalEnergy += referenceData[hopSize + i] * referenceData[hopSize + i];
+        
+        // Calculate Energy of noise
+        signalDifference = referenceData[hopSize + i] - ifftData[hopSize + i];    
+
+        noiseEnergy += signalDifference * signalDifference;
+    }
+
+    std::cout << "-----------------------------------------------" << "\n";
+    std::cout << "Energy of signal: " << signalEnergy << "\n";
+    std::cout << "Energy of noise: " << noiseEnergy << "\n";
+    
+    // Calculate SNR
+    return 10 * log10(signalEnergy / noiseEnergy);
+}
+
+// Engine time for one second of 16 channel noise in milliseconds
+template <typename T>
+double measureCost(const std::vector<Partial<float>>& signalData, int frameSize, int overlapFactor)
+{
+    IFFT<T> ifft = IFFT<T>(frameSize, overlapFactor, WindowType::BlackmanHarris4term, 16, 7);
+    ifft.setSampleRate(sampleRate);
+    ifft.setChannels(AC);
+
+    const int hops = static_cast<int>(sampleRate) / ifft.getHopSize();
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < hops; ++i)
+    {
+        ifft.createSpectrum(signalData);
+        ifft.IFFTprocess();
+    }
+
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Renders noise through IFFT<T> with the motif noise floor and compares all channels against
+// the full motif, binsPerPartial returns the mean motif bins of the narrowed render
+template <typename T>
+double measureLOD(const std::vector<Partial<float>>& signalData, T noiseFloor, double& binsPerPartial)
+{
+    const int hopCount = bufferCount * 4;
+
+    IFFT<T> full = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 16, 7);
+    IFFT<T> narrowed = IFFT<T>(4 * bufferSize, 4, WindowType::BlackmanHarris4term, 16, 7);
+    full.setSampleRate(sampleRate);
+    narrowed.setSampleRate(sampleRate);
+    narrowed.setMotifNoiseFloor(noiseFloor);
+
+    double signalEnergy = 0.0;
+    double noiseEnergy = 0.0;
+    binsPerPartial = 0.0;
+
+    for (int i = 0; i < hopCount; ++i)
+    {
+        full.createSpectrum(signalData);
+        full.IFFTprocess();
+        narrowed.createSpectrum(signalData);
+        narrowed.IFFTprocess();
+
+        binsPerPartial += narrowed.getMotifBinsPerPartial() / hopCount;
+
+        // First hop is discarded because there is no overlap data yet
+        if (i == 0)
+            continue;
+
+        for (int c = 0; c < AC; ++c)
+        {
+            for (int j = 0; j < full.getHopSize(); ++j)
+            {
+                const double difference = static_cast<double>(full.bufferArray[c][j]) - narrowed.bufferArray[c][j];
+                signalEnergy += static_cast<double>(full.bufferArray[c][j]) * full.bufferArray[c][j];
+                noiseEnergy += difference * difference;
+            }
+        }
+    }
+
+    return 10 * log10(signalEnergy / noiseEnergy);
+}
+
+// Samples from a note-on at changeOffset to the first sample at half the final amplitude.
+// Like the plugin's FIFO, a hop only sees the partials of its first sample, so the sine
+// enters with the first hop at or after the note-on
+template <typename T>
+int measureOnset(const std::vector<Partial<float>>& signalData, int frameSize, int overlapFactor, int changeOffset)
+{
+    IFFT<T> ifft = IFFT<T>(frameSize, overlapFactor, WindowType::BlackmanHarris4term, 16, 7);
+    ifft.setSampleRate(sampleRate);
+
+    const int hopSize = ifft.getHopSize();
+    const int noteOn = 2 * frameSize + changeOffset; // Silent frames before, so the overlap is settled
+    const int hopCount = (noteOn + 2 * frameSize) / hopSize;
+    const std::vector<Partial<float>> silence;
+
+    for (int i = 0; i < hopCount; ++i)
+    {
+        ifft.createSpectrum(i * hopSize >= noteOn ? signalData : silence);
+        ifft.IFFTprocess();
+
+        for (int j = 0; j < hopSize; ++j)
+        {
+            if (std::abs(ifft.bufferArray[0][j]) >= 0.5)
+                return i * hopSize + j - noteOn;
+        }
+    }
+
+    return hopCount * hopSize - noteOn;
+}
+
+// Renders one second of a sine through IFFT<T> with or without the adaptive hop. With moving, a
+// silent second partial changes its frequency on a random third of the hops, so the hop keeps
+// switching while the output should stay the sine
+template <typename T>
+double measureAdaptive(int overlapFactor, bool adaptive, bool moving, double frequency, int& spectra)
+{
+    IFFT<T> ifft = IFFT<T>(4 * bufferSize, overlapFactor, WindowType::BlackmanHarris4term, 16, 7);
+    ifft.setSampleRate(sampleRate);
+
+    if (!ifft.setAdaptiveHop(adaptive))
+        std::cout << "Adaptive hop rejected at overlap factor " << overlapFactor << "\n";
+
+    std::vector<Partial<float>> partials(2);
+    partials[0].frequency = static_cast<float>(frequency);
+    partials[1].frequency = 3000.0f;
+    partials[1].amplitude = 0.0f;
+
+    for (auto& partial: partials)
+        partial.setBFormat(Normalisation::SN3D);
+
+    std::vector<double> ifftData;
+    std::mt19937 random(1);
+    spectra = 0;
+
+    while (ifftData.size() < static_cast<size_t>(sampleRate))
+    {
+        if (moving && random() % 3 == 0)
+            partials[1].frequency += 1.0f;
+
+        ifft.createSpectrum(partials);
+        ifft.IFFTprocess();
+        ++spectra;
+
+        for (int j = 0; j < ifft.getHopSize(); ++j)
+            ifftData.push_back(ifft.bufferArray[0][j]);
+    }
+
+    // The first hop is always short and discarded, the reference starts half a hop before it
+    const int firstHop = 4 * bufferSize / overlapFactor;
+    const double angleDelta = frequency / sampleRate * 2 * M_PI;
+    double signalEnergy = 0.0;
+    double noiseEnergy = 0.0;
+
+    for (size_t n = firstHop; n < ifftData.size(); ++n)
+    {
+        const double reference = std::cos(angleDelta * (n - 0.5 * firstHop));
+        signalEnergy += reference * reference;
+        noiseEnergy += (reference - ifftData[n]) * (reference - ifftData[n]);
+    }
+
+    return 10 * log10(signalEnergy / noiseEnergy);
+}
+
+// Renders half a second of a sine through IFFT<T> with the frame size at overlap factor 4
+template <typename T>
+double measureFrameSize(int frameSize, double frequency)
+{
+    IFFT<T> ifft = IFFT<T>(frameSize, 4, WindowType::BlackmanHarris4term, 16, 7);
+    ifft.setSampleRate(sampleRate);
+
+    std::vector<Partial<float>> partials(1);
+    partials[0].frequency = static_cast<float>(frequency);
+    partials[0].setBFormat(Normalisation::SN3D);
+
+    const int hopSize = ifft.getHopSize();
+    const int hops = static_cast<int>(sampleRate) / (2 * hopSize);
+    std::vector<double> ifftData(hops * hopSize);
+
+    for (int i = 0; i < hops; ++i)
+    {
+        ifft.createSpectrum(partials);
+        ifft.IFFTprocess();
+
+        for (int j = 0; j < hopSize; ++j)
+            ifftData[i * hopSize + j] = ifft.bufferArray[0][j];
+    }
+
+    // The first hop has no overlap and is discarded, the reference starts half a hop before it
+    const double angleDelta = frequency / sampleRate * 2 * M_PI;
+    double signalEnergy = 0.0;
+    double noiseEnergy = 0.0;
+
+    for (int n = hopSize; n < hops * hopSize; ++n)
+    {
+        const double reference = std::cos(angleDelta * (n - 0.5 * hopSize));
+        signalEnergy += reference * reference;
+        noiseEnergy += (reference - ifftData[n]) * (reference - ifftData[n]);
+    }
+
+    return 10 * log10(signalEnergy / noiseEnergy);
+}
+
 int main()
 {
     if (SNR_K)
     {
         // Constant data
         const float frequency = 968.719; // Unfavourable bin location: For example Sample rate / IFFT size * 10.333
-        const int oversamplingFactor = 128;
+        const int oversamplingFactor = 16;
         
         // Prepare .csv file
         std::ostringstream filePath;
@@ -30,17 +296,12 @@ int main()
         snrDataFile << "Buffer size:" << "," << bufferSize << "\n";
         snrDataFile << "Frequency:" << "," << frequency << "\n";
         snrDataFile << "Oversampling factor:" << "," << oversamplingFactor << "\n" << "\n";
+        snrDataFile << "K" << "," << "SNR linear double" << "," << "SNR linear float" << "," << "SNR cubic double" << "," << "SNR cubic float" << "\n";
 
         std::cout << "-----------------------------------------------" << "\n";
         std::cout << "--------------Signal-to-noise Ratio------------" << "\n";
         std::cout << "-----------------------------------------------" << "\n";
 
-        // Initialize data buffer
-        std::vector<double> referenceData;
-        std::vector<double> ifftData;
-        referenceData.resize(bufferCount * bufferSize);
-        ifftData.resize(bufferCount * bufferSize); 
-        
         // Create test signal
         BasicSignals signal = BasicSignals(SignalType::sine, 1.0, frequency, frequency, 0.0); 
         signal.setSpatialParameters(1.0, 0.0, 0.0);
@@ -59,62 +320,18 @@ int main()
             
             for (int K = 3; K <= 11; K += 2)
             {
-                // Create IFFT data
-                IFFT ifft = IFFT(4 * bufferSize, windowType, oversamplingFactor, K);
-                ifft.setSampleRate(sampleRate);
-
-                for (int i = 0; i < bufferCount; ++i)
-                {     
-                    ifft.createSpectrum(signalData);
-                    ifft.IFFTprocess();
-                    
-                    for (int j = 0; j < bufferSize; ++j)
-                    {
-                        ifftData[i * bufferSize + j] = ifft.bufferArray[0][j];
-                    }
-                }
-                
-                // Calculate Energy of signal and noise and compare signals
-                double signalEnergy = 0.0;
-                double noiseEnergy = 0.0;
-                double signalDifference = 0.0;
-
-                // Start reference data at the initial phase of IFFT data
-                double currentAngle = std::fmod(2 * M_PI * frequency * 0.5 * bufferSize * 1.0 / sampleRate, 2 * M_PI);
-
-                double angleDelta = frequency / sampleRate * 2 * M_PI;
-
-                for (int i = 0; i < (bufferCount - 1) * bufferSize; ++i)
-                {     
-                    referenceData[bufferSize + i] = std::cos(currentAngle);
-                    currentAngle += angleDelta;
-                    if (currentAngle >= 2 * M_PI)
-                        currentAngle -= 2 * M_PI;
-                    
-                    // First buffers are discarded because there is no overlap data yet
-                    
-                    // Calculate Energy of signal
-                    signalEnergy += referenceData[bufferSize + i] * referenceData[bufferSize + i];
-                    
-                    // Calculate Energy of noise
-                    signalDifference = referenceData[bufferSize + i] - ifftData[bufferSize + i];    
-
-                    noiseEnergy += signalDifference * signalDifference;
-                }
-
-                std::cout << "-----------------------------------------------" << "\n";
-                std::cout << "Energy of signal: " << signalEnergy << "\n";
-                std::cout << "Energy of noise: " << noiseEnergy << "\n";
-                
-                // Calculate SNR
-                double SNR = 10 * log10(signalEnergy / noiseEnergy);
+                double SNRLinear = measureSNR<double>(signalData, windowType, oversamplingFactor, K, frequency, 4, MotifInterpolation::Linear);
+                double SNRLinearFloat = measureSNR<float>(signalData, windowType, oversamplingFactor, K, frequency, 4, MotifInterpolation::Linear);
+                double SNR = measureSNR<double>(signalData, windowType, oversamplingFactor, K, frequency, 4, MotifInterpolation::Cubic);
+                double SNRFloat = measureSNR<float>(signalData, windowType, oversamplingFactor, K, frequency, 4, MotifInterpolation::Cubic);
 
                 std::cout   << "Signal-to-noise Ratio for K = " << K 
                             << " and window type = " << windowNames[windowCount]
-                            << ": " << SNR << " dB" << "\n"; 
+                            << ": " << SNRLinear << " dB (linear double), " << SNRLinearFloat << " dB (linear float), "
+                            << SNR << " dB (cubic double), " << SNRFloat << " dB (cubic float)" << "\n"; 
                 std::cout << "-----------------------------------------------" << "\n";
                 
-                snrDataFile << K << "," << SNR << "\n";
+                snrDataFile << K << "," << SNRLinear << "," << SNRLinearFloat << "," << SNR << "," << SNRFloat << "\n";
             }
             ++windowCount;
         }
@@ -139,19 +356,14 @@ int main()
         snrDataFile << "Buffer size:" << "," << bufferSize << "\n";
         snrDataFile << "K:" << "," << K << "\n";
         snrDataFile << "Window type:" << "," << windowName << "\n" << "\n";
+        snrDataFile << "Frequency" << "," << "SNR double" << "," << "SNR float" << "\n";
 
         std::cout << "-----------------------------------------------" << "\n";
         std::cout << "--------------Signal-to-noise Ratio------------" << "\n";
         std::cout << "-----------------------------------------------" << "\n";
 
-        // Initialize data buffer
-        std::vector<double> referenceData;
-        std::vector<double> ifftData;
-        referenceData.resize(bufferCount * bufferSize);
-        ifftData.resize(bufferCount * bufferSize); 
-        
         // Oversampling factors
-        std::vector<int> oversamplingFactors = {512};
+        std::vector<int> oversamplingFactors = {8, 16, 128};
 
         for (auto O: oversamplingFactors)
         {
@@ -166,67 +378,316 @@ int main()
                 signal.setElevationDisplacement(static_cast<DisplacementFunction>(0), 0.0, 0.0);
                 auto signalData = signal.getPartials();
                 
-                // Create IFFT data
-                IFFT ifft = IFFT(4 * bufferSize, window, O, K);
-                ifft.setSampleRate(sampleRate);
-
-                for (int i = 0; i < bufferCount; ++i)
-                {     
-                    ifft.createSpectrum(signalData);
-                    ifft.IFFTprocess();
-                    
-                    for (int j = 0; j < bufferSize; ++j)
-                    {
-                        ifftData[i * bufferSize + j] = ifft.bufferArray[0][j];
-                    }
-                }
-                
-                // Calculate Energy of signal and noise and compare signals
-                double signalEnergy = 0.0;
-                double noiseEnergy = 0.0;
-                double signalDifference = 0.0;
-
-                // Start reference data at the initial phase of IFFT data
-                double currentAngle = std::fmod(2 * M_PI * frequency * 0.5 * bufferSize * 1.0 / sampleRate, 2 * M_PI);
-                
-                double angleDelta = frequency / sampleRate * 2 * M_PI;
-
-                for (int i = 0; i < (bufferCount - 1) * bufferSize; ++i)
-                {     
-                    referenceData[bufferSize + i] = std::cos(currentAngle);
-                    currentAngle += angleDelta;
-                    if (currentAngle >= 2 * M_PI)
-                        currentAngle -= 2 * M_PI;
-                    
-                    // First buffers are discarded because there is no overlap data yet
-                    
-                    // Calculate Energy of signal
-                    signalEnergy += referenceData[bufferSize + i] * referenceData[bufferSize + i];
-                    
-                    // Calculate Energy of noise
-                    signalDifference = referenceData[bufferSize + i] - ifftData[bufferSize + i];    
-
-                    noiseEnergy += signalDifference * signalDifference;
-                }
-
-                std::cout << "-----------------------------------------------" << "\n";
-                std::cout << "Energy of signal: " << signalEnergy << "\n";
-                std::cout << "Energy of noise: " << noiseEnergy << "\n";
-                
-                // Calculate SNR
-                double SNR = 10 * log10(signalEnergy / noiseEnergy);
+                double SNR = measureSNR<double>(signalData, window, O, K, frequency, 4, MotifInterpolation::Cubic);
+                double SNRFloat = measureSNR<float>(signalData, window, O, K, frequency, 4, MotifInterpolation::Cubic);
 
                 std::cout   << "Signal-to-noise Ratio for O = " << O 
                             << " and frequency = " << frequency
-                            << ": " << SNR << " dB" << "\n"; 
+                            << ": " << SNR << " dB (double), " << SNRFloat << " dB (float)" << "\n"; 
                 std::cout << "-----------------------------------------------" << "\n";
                 
-                snrDataFile << frequency << "," << SNR << "\n";
+                snrDataFile << frequency << "," << SNR << "," << SNRFloat << "\n";
             }
         }
         
         snrDataFile.close();
     }
 
+    if (SNR_OVERLAP)
+    {
+        // Constant data
+        const float frequency = 968.719;
+        const int oversamplingFactor = 16;
+        const int K = 7;
+        const int partialCount = 1000;
+
+        // Prepare .csv file
+        std::ostringstream filePath;
+        filePath << "./" << "SNR_Overlap" << ".csv";
+        std::ofstream snrDataFile;
+        snrDataFile.open(filePath.str());
+
+        snrDataFile << "Signal-to-noise ratio and cost per overlap factor" << "\n" << "\n";
+        snrDataFile << "Sample rate:" << "," << sampleRate << "\n";
+        snrDataFile << "Frame size:" << "," << 4 * bufferSize << "\n";
+        snrDataFile << "Frequency:" << "," << frequency << "\n";
+        snrDataFile << "K:" << "," << K << "\n";
+        snrDataFile << "Window type:" << "," << "Blackman-Harris four-term" << "\n";
+        snrDataFile << "Cost:" << "," << partialCount << " noise partials" << "," << AC << " channels" << "\n" << "\n";
+        snrDataFile << "Overlap factor" << "," << "Hop size" << "," << "Spectra per second" << "," 
+                    << "SNR double" << "," << "SNR float" << "," << "Cost double [ms/s]" << "," << "Cost float [ms/s]" << "\n";
+
+        BasicSignals signal = BasicSignals(SignalType::sine, 1.0, frequency, frequency, 0.0); 
+        signal.setSpatialParameters(1.0, 0.0, 0.0);
+        signal.setAzimuthDisplacement(static_cast<DisplacementFunction>(0), 0.0, 0.0);
+        signal.setElevationDisplacement(static_cast<DisplacementFunction>(0), 0.0, 0.0);
+        auto signalData = signal.getPartials();
+
+        BasicSignals noise = BasicSignals(SignalType::noise, 0.5, 440.0, 440.0, 0.0);
+        noise.reset();
+        noise.setNumberOfPartials(partialCount);
+        noise.createSignal(SignalType::noise);
+        noise.setSpatialParameters(1.0, 0.5, 0.2);
+        noise.setAzimuthDisplacement(DisplacementFunction::sin, 0.8, 3.0);
+        noise.setElevationDisplacement(DisplacementFunction::cos, 0.4, 2.0);
+        auto noiseData = noise.getPartials();
+
+        for (int overlapFactor = 2; overlapFactor <= 8; overlapFactor *= 2)
+        {
+            const int hopSize = 4 * bufferSize / overlapFactor;
+
+            double SNR = measureSNR<double>(signalData, WindowType::BlackmanHarris4term, oversamplingFactor, K, frequency, overlapFactor, MotifInterpolation::Cubic);
+            double SNRFloat = measureSNR<float>(signalData, WindowType::BlackmanHarris4term, oversamplingFactor, K, frequency, overlapFactor, MotifInterpolation::Cubic);
+            double cost = measureCost<double>(noiseData, 4 * bufferSize, overlapFactor);
+            double costFloat = measureCost<float>(noiseData, 4 * bufferSize, overlapFactor);
+
+            std::cout   << "Overlap factor " << overlapFactor 
+                        << ": " << SNR << " dB (double), " << SNRFloat << " dB (float), "
+                        << cost << " ms/s (double), " << costFloat << " ms/s (float)" << "\n"; 
+            std::cout << "-----------------------------------------------" << "\n";
+
+            snrDataFile << overlapFactor << "," << hopSize << "," << sampleRate / hopSize << ","
+                        << SNR << "," << SNRFloat << "," << cost << "," << costFloat << "\n";
+        }
+
+        snrDataFile.close();
+    }
+
+    if (SNR_LOD)
+    {
+        // Constant data
+        const int partialCount = 1000;
+        const float brightnesses[] = {10.0f, 250.0f}; // Damping of BasicSignals::setBrightness: the plugin's default and brightest setting
+
+        // Prepare .csv file
+        std::ostringstream filePath;
+        filePath << "./" << "SNR_LOD" << ".csv";
+        std::ofstream snrDataFile;
+        snrDataFile.open(filePath.str());
+
+        snrDataFile << "Signal-to-noise ratio of the amplitude driven motif width against the full motif" << "\n" << "\n";
+        snrDataFile << "Sample rate:" << "," << sampleRate << "\n";
+        snrDataFile << "Frame size:" << "," << 4 * bufferSize << "\n";
+        snrDataFile << "K:" << "," << 7 << "\n";
+        snrDataFile << "Window type:" << "," << "Blackman-Harris four-term" << "\n";
+        snrDataFile << "Signal:" << "," << partialCount << " noise partials" << "," << AC << " channels" << "\n" << "\n";
+        snrDataFile << "Noise floor [dB]" << "," << "Bins per partial" << "," << "SNR double" << "," << "SNR float" << "," << "Target met" << "\n";
+
+        for (auto brightness: brightnesses)
+        {
+            snrDataFile << "Brightness:" << "," << brightness << "\n";
+
+            BasicSignals noise = BasicSignals(SignalType::noise, 0.5, 440.0, 440.0, 0.0);
+            noise.reset();
+            noise.setNumberOfPartials(partialCount);
+            noise.createSignal(SignalType::noise);
+            noise.setBrightness(brightness);
+            noise.setSpatialParameters(1.0, 0.5, 0.2);
+            noise.setAzimuthDisplacement(DisplacementFunction::sin, 0.8, 3.0);
+            noise.setElevationDisplacement(DisplacementFunction::cos, 0.4, 2.0);
+            auto noiseData = noise.getPartials();
+
+            for (int noiseFloor = -40; noiseFloor >= -100; noiseFloor -= 20)
+            {
+                double bins = 0.0;
+                double binsFloat = 0.0;
+                double SNR = measureLOD<double>(noiseData, noiseFloor, bins);
+                double SNRFloat = measureLOD<float>(noiseData, static_cast<float>(noiseFloor), binsFloat);
+
+                // The floor bounds the truncation error, float rounding adds its own
+                const bool targetMet = SNR >= -noiseFloor;
+
+                std::cout   << "Brightness " << brightness << ", motif noise floor " << noiseFloor 
+                            << " dB: " << bins << " bins per partial, " << SNR << " dB (double), " << SNRFloat << " dB (float)"
+                            << (targetMet ? "" : ", target missed") << "\n"; 
+                std::cout << "-----------------------------------------------" << "\n";
+
+                snrDataFile << noiseFloor << "," << bins << "," << SNR << "," << SNRFloat << "," << (targetMet ? "yes" : "no") << "\n";
+            }
+        }
+
+        snrDataFile.close();
+    }
+
+    if (SNR_ONSET)
+    {
+        // Constant data
+        const float frequency = 4800.0; // Period of 10 samples, so the peak of the first cycle above half amplitude is at most 5 samples late
+        const int modes[][2] = {{1024, 8}, {1024, 4}, {1024, 2}, {256, 4}}; // Frame size and overlap factor, {256, 4} is the plugin's LOWLATENCY mode
+
+        // Prepare .csv file
+        std::ostringstream filePath;
+        filePath << "./" << "SNR_Onset" << ".csv";
+        std::ofstream snrDataFile;
+        snrDataFile.open(filePath.str());
+
+        snrDataFile << "Delay from a note-on to half the final amplitude, note-ons at every sample of a hop" << "\n" << "\n";
+        snrDataFile << "Sample rate:" << "," << sampleRate << "\n";
+        snrDataFile << "Frequency:" << "," << frequency << "\n";
+        snrDataFile << "K:" << "," << 7 << "\n";
+        snrDataFile << "Window type:" << "," << "Blackman-Harris four-term" << "\n" << "\n";
+        snrDataFile << "Frame size" << "," << "Overlap factor" << "," << "Hop size" << "," 
+                    << "Minimum [samples]" << "," << "Mean [samples]" << "," << "Maximum [samples]" << "," << "Mean [ms]" << "\n";
+
+        BasicSignals signal = BasicSignals(SignalType::sine, 1.0, frequency, frequency, 0.0); 
+        signal.setSpatialParameters(1.0, 0.0, 0.0);
+        signal.setAzimuthDisplacement(static_cast<DisplacementFunction>(0), 0.0, 0.0);
+        signal.setElevationDisplacement(static_cast<DisplacementFunction>(0), 0.0, 0.0);
+        auto signalData = signal.getPartials();
+
+        for (auto mode: modes)
+        {
+            const int frameSize = mode[0];
+            const int overlapFactor = mode[1];
+            const int hopSize = frameSize / overlapFactor;
+
+            int minimum = frameSize;
+            int maximum = -frameSize;
+            double mean = 0.0;
+
+            for (int changeOffset = 0; changeOffset < hopSize; ++changeOffset)
+            {
+                const int onset = measureOnset<float>(signalData, frameSize, overlapFactor, changeOffset);
+                minimum = std::min(minimum, onset);
+                maximum = std::max(maximum, onset);
+                mean += static_cast<double>(onset) / hopSize;
+            }
+
+            std::cout   << "Frame " << frameSize << ", overlap factor " << overlapFactor 
+                        << ": onset after " << minimum << " to " << maximum << " samples, mean " << mean 
+                        << " samples (" << 1000.0 * mean / sampleRate << " ms)" << "\n"; 
+            std::cout << "-----------------------------------------------" << "\n";
+
+            snrDataFile << frameSize << "," << overlapFactor << "," << hopSize << ","
+                        << minimum << "," << mean << "," << maximum << "," << 1000.0 * mean / sampleRate << "\n";
+        }
+
+        snrDataFile.close();
+    }
+
+    if (SNR_ADAPTIVE)
+    {
+        // Constant data
+        const float frequency = 968.719;
+        const int overlapFactor = 8; // The adaptive hop is rejected below 8
+
+        // Prepare .csv file
+        std::ostringstream filePath;
+        filePath << "./" << "SNR_Adaptive" << ".csv";
+        std::ofstream snrDataFile;
+        snrDataFile.open(filePath.str());
+
+        snrDataFile << "Signal-to-noise ratio and spectra per second of the adaptive hop" << "\n" << "\n";
+        snrDataFile << "Sample rate:" << "," << sampleRate << "\n";
+        snrDataFile << "Frame size:" << "," << 4 * bufferSize << "\n";
+        snrDataFile << "Frequency:" << "," << frequency << "\n";
+        snrDataFile << "K:" << "," << 7 << "\n";
+        snrDataFile << "Window type:" << "," << "Blackman-Harris four-term" << "\n";
+        snrDataFile << "Moving:" << "," << "a silent partial changes on a random third of the hops" << "\n";
+        snrDataFile << "Overlap factor:" << "," << overlapFactor << "\n" << "\n";
+        snrDataFile << "Scene" << "," << "Spectra fixed" << "," << "Spectra adaptive" << "," 
+                    << "SNR fixed double" << "," << "SNR adaptive double" << "," << "SNR adaptive float" << "\n";
+
+        for (int moving = 0; moving <= 1; ++moving)
+        {
+            int spectra = 0;
+            int spectraAdaptive = 0;
+            int spectraFloat = 0;
+            double SNR = measureAdaptive<double>(overlapFactor, false, moving, frequency, spectra);
+            double SNRAdaptive = measureAdaptive<double>(overlapFactor, true, moving, frequency, spectraAdaptive);
+            double SNRFloat = measureAdaptive<float>(overlapFactor, true, moving, frequency, spectraFloat);
+
+            std::cout   << "Overlap factor " << overlapFactor << (moving ? ", moving" : ", held") 
+                        << ": " << spectra << " spectra, " << SNR << " dB fixed, " 
+                        << spectraAdaptive << " spectra, " << SNRAdaptive << " dB (double), " << SNRFloat << " dB (float) adaptive" << "\n"; 
+            std::cout << "-----------------------------------------------" << "\n";
+
+            snrDataFile << (moving ? "moving" : "held") << "," << spectra << "," << spectraAdaptive << ","
+                        << SNR << "," << SNRAdaptive << "," << SNRFloat << "\n";
+        }
+
+        snrDataFile.close();
+    }
+
+    if (SNR_FRAMESIZE)
+    {
+        // Constant data
+        const int frameSizes[] = {1024, 256}; // The default frames and the plugin's LOWLATENCY frames
+        const double frequencies[] = {20.0, 50.0, 100.0, 200.0, 500.0, 1000.0, 5000.0, 15000.0, 23700.0};
+        const int partialCounts[] = {100, 1000, 10000};
+
+        // Prepare .csv file
+        std::ostringstream filePath;
+        filePath << "./" << "SNR_FrameSize" << ".csv";
+        std::ofstream snrDataFile;
+        snrDataFile.open(filePath.str());
+
+        snrDataFile << "Signal-to-noise ratio over frequency and cost over partial count per frame size" << "\n" << "\n";
+        snrDataFile << "Sample rate:" << "," << sampleRate << "\n";
+        snrDataFile << "Overlap factor:" << "," << 4 << "\n";
+        snrDataFile << "K:" << "," << 7 << "\n";
+        snrDataFile << "Window type:" << "," << "Blackman-Harris four-term" << "\n";
+        snrDataFile << "Cost:" << "," << "noise partials" << "," << AC << " channels" << "\n" << "\n";
+        snrDataFile << "Frequency [Hz]";
+
+        for (auto frameSize: frameSizes)
+            snrDataFile << "," << "SNR " << frameSize << " double" << "," << "SNR " << frameSize << " float";
+
+        snrDataFile << "\n";
+
+        for (auto frequency: frequencies)
+        {
+            snrDataFile << frequency;
+            std::cout << frequency << " Hz:";
+
+            for (auto frameSize: frameSizes)
+            {
+                double SNR = measureFrameSize<double>(frameSize, frequency);
+                double SNRFloat = measureFrameSize<float>(frameSize, frequency);
+
+                std::cout << " frame " << frameSize << " " << SNR << " dB (double), " << SNRFloat << " dB (float);";
+                snrDataFile << "," << SNR << "," << SNRFloat;
+            }
+
+            std::cout << "\n" << "-----------------------------------------------" << "\n";
+            snrDataFile << "\n";
+        }
+
+        snrDataFile << "\n" << "Partials";
+
+        for (auto frameSize: frameSizes)
+            snrDataFile << "," << "Cost " << frameSize << " float [ms/s]";
+
+        snrDataFile << "\n";
+
+        for (auto partialCount: partialCounts)
+        {
+            BasicSignals noise = BasicSignals(SignalType::noise, 0.5, 440.0, 440.0, 0.0);
+            noise.reset();
+            noise.setNumberOfPartials(partialCount);
+            noise.createSignal(SignalType::noise);
+            noise.setSpatialParameters(1.0, 0.5, 0.2);
+            noise.setAzimuthDisplacement(DisplacementFunction::sin, 0.8, 3.0);
+            noise.setElevationDisplacement(DisplacementFunction::cos, 0.4, 2.0);
+            auto noiseData = noise.getPartials();
+
+            snrDataFile << partialCount;
+            std::cout << partialCount << " partials:";
+
+            for (auto frameSize: frameSizes)
+            {
+                double costFloat = measureCost<float>(noiseData, frameSize, 4);
+
+                std::cout << " frame " << frameSize << " " << costFloat << " ms/s (float);";
+                snrDataFile << "," << costFloat;
+            }
+
+            std::cout << "\n" << "-----------------------------------------------" << "\n";
+            snrDataFile << "\n";
+        }
+
+        snrDataFile.close();
+    }
+
     return 0;
 }
\ No newline at end of file